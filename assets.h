@@ -0,0 +1,116 @@
+/*
+ * Compressed Assets - generated by tools/mkasset.py, do not edit
+ */
+
+struct Asset {
+  const uint8_t *data; //pixel runs, see tools/mkasset.py
+  uint16_t size, width, height;
+};
+
+const uint8_t dorianData[] PROGMEM = {
+  // assets/dorian.h, 200x180px, 4500 bytes raw
+  0x00, 0x62, 0x05, 0x12, 0x01, 0xa9, 0x01, 0x0c, 0x05, 0x03, 0xaa, 0x01, 0x17, 0x05, 0x03, 0xa4,
+  0x01, 0x1d, 0x02, 0x07, 0xa0, 0x01, 0x0d, 0x02, 0x1d, 0x9c, 0x01, 0x04, 0x03, 0x01, 0x07, 0x1e,
+  0x98, 0x01, 0x02, 0x0f, 0x22, 0x09, 0x04, 0x98, 0x01, 0x31, 0x01, 0x05, 0x9b, 0x01, 0x1c, 0x02,
+  0x06, 0x09, 0x03, 0x95, 0x01, 0x20, 0x01, 0x08, 0xa5, 0x01, 0x1f, 0xa8, 0x01, 0x1d, 0x15, 0x01,
+  0x94, 0x01, 0x23, 0x03, 0x02, 0x03, 0x0c, 0x91, 0x01, 0x26, 0x01, 0x01, 0x03, 0x03, 0x02, 0x09,
+  0x90, 0x01, 0x23, 0x01, 0x06, 0x03, 0x0d, 0x8c, 0x01, 0x3d, 0x8b, 0x01, 0x01, 0x05, 0x38, 0x76,
+  0x05, 0x0c, 0x06, 0x08, 0x33, 0x03, 0x02, 0x80, 0x01, 0x08, 0x0a, 0x32, 0x03, 0x01, 0x53, 0x01,
+  0x01, 0x02, 0x02, 0x02, 0x22, 0x08, 0x0f, 0x31, 0x03, 0x01, 0x51, 0x01, 0x01, 0x01, 0x03, 0x02,
+  0x21, 0x0a, 0x13, 0x01, 0x01, 0x2b, 0x56, 0x01, 0x04, 0x01, 0x20, 0x0a, 0x1a, 0x16, 0x06, 0x0d,
+  0x03, 0x01, 0x4f, 0x02, 0x03, 0x05, 0x1c, 0x02, 0x01, 0x02, 0x24, 0x03, 0x04, 0x07, 0x08, 0x10,
+  0x03, 0x01, 0x4d, 0x0b, 0x1a, 0x04, 0x2b, 0x03, 0x01, 0x03, 0x02, 0x01, 0x06, 0x14, 0x02, 0x02,
+  0x4c, 0x0b, 0x19, 0x03, 0x3b, 0x16, 0x02, 0x02, 0x4b, 0x0b, 0x16, 0x06, 0x05, 0x03, 0x32, 0x19,
+  0x01, 0x02, 0x4b, 0x0b, 0x10, 0x0c, 0x03, 0x04, 0x1f, 0x01, 0x12, 0x1d, 0x4a, 0x0d, 0x0d, 0x0d,
+  0x02, 0x05, 0x20, 0x01, 0x12, 0x1d, 0x4a, 0x0b, 0x0c, 0x13, 0x02, 0x01, 0x25, 0x03, 0x0d, 0x1c,
+  0x49, 0x0b, 0x0c, 0x0f, 0x03, 0x01, 0x28, 0x07, 0x04, 0x02, 0x05, 0x1b, 0x49, 0x0c, 0x01, 0x01,
+  0x07, 0x0f, 0x2f, 0x07, 0x02, 0x05, 0x05, 0x19, 0x49, 0x0e, 0x05, 0x10, 0x32, 0x07, 0x02, 0x04,
+  0x06, 0x17, 0x48, 0x0e, 0x05, 0x0f, 0x37, 0x04, 0x03, 0x03, 0x02, 0x03, 0x01, 0x17, 0x48, 0x0e,
+  0x02, 0x10, 0x01, 0x01, 0x38, 0x25, 0x48, 0x21, 0x3c, 0x22, 0x49, 0x1e, 0x3f, 0x13, 0x01, 0x0e,
+  0x48, 0x1d, 0x44, 0x0e, 0x03, 0x0e, 0x47, 0x1e, 0x3e, 0x01, 0x05, 0x0e, 0x04, 0x0b, 0x47, 0x1f,
+  0x47, 0x0c, 0x02, 0x01, 0x01, 0x0b, 0x01, 0x01, 0x45, 0x1d, 0x49, 0x0b, 0x05, 0x01, 0x01, 0x0a,
+  0x01, 0x01, 0x43, 0x1c, 0x4b, 0x0a, 0x05, 0x0d, 0x02, 0x01, 0x41, 0x1d, 0x4b, 0x0a, 0x05, 0x0d,
+  0x02, 0x01, 0x40, 0x1e, 0x4d, 0x04, 0x02, 0x02, 0x04, 0x0f, 0x01, 0x01, 0x40, 0x1d, 0x4e, 0x03,
+  0x03, 0x01, 0x06, 0x01, 0x01, 0x0d, 0x01, 0x01, 0x3f, 0x1d, 0x4e, 0x03, 0x03, 0x01, 0x03, 0x01,
+  0x04, 0x08, 0x01, 0x04, 0x01, 0x01, 0x3f, 0x20, 0x4b, 0x02, 0x04, 0x01, 0x03, 0x01, 0x04, 0x08,
+  0x02, 0x03, 0x02, 0x02, 0x3d, 0x1c, 0x58, 0x01, 0x05, 0x08, 0x02, 0x01, 0x04, 0x02, 0x3d, 0x1a,
+  0x5a, 0x01, 0x05, 0x09, 0x02, 0x02, 0x40, 0x1b, 0x60, 0x04, 0x01, 0x04, 0x02, 0x02, 0x01, 0x01,
+  0x3d, 0x1c, 0x60, 0x04, 0x01, 0x05, 0x01, 0x04, 0x3c, 0x1e, 0x5d, 0x01, 0x01, 0x04, 0x01, 0x0b,
+  0x3a, 0x09, 0x01, 0x12, 0x5f, 0x02, 0x01, 0x05, 0x01, 0x09, 0x01, 0x02, 0x01, 0x01, 0x35, 0x09,
+  0x02, 0x0b, 0x66, 0x01, 0x01, 0x06, 0x01, 0x0c, 0x02, 0x01, 0x33, 0x09, 0x03, 0x05, 0x02, 0x02,
+  0x3b, 0x09, 0x26, 0x06, 0x02, 0x0e, 0x32, 0x09, 0x03, 0x06, 0x3b, 0x0e, 0x24, 0x07, 0x02, 0x0f,
+  0x30, 0x09, 0x04, 0x05, 0x32, 0x01, 0x01, 0x16, 0x24, 0x07, 0x02, 0x10, 0x30, 0x07, 0x05, 0x05,
+  0x03, 0x06, 0x28, 0x1a, 0x14, 0x01, 0x0e, 0x07, 0x03, 0x10, 0x2f, 0x07, 0x04, 0x06, 0x02, 0x10,
+  0x1d, 0x1c, 0x14, 0x01, 0x0e, 0x07, 0x03, 0x11, 0x2e, 0x07, 0x04, 0x05, 0x03, 0x10, 0x1d, 0x1d,
+  0x21, 0x08, 0x04, 0x11, 0x2d, 0x06, 0x05, 0x05, 0x02, 0x11, 0x22, 0x1b, 0x1e, 0x02, 0x01, 0x05,
+  0x04, 0x12, 0x2c, 0x06, 0x04, 0x06, 0x03, 0x10, 0x23, 0x1b, 0x1b, 0x01, 0x01, 0x02, 0x01, 0x05,
+  0x04, 0x12, 0x2c, 0x06, 0x04, 0x06, 0x02, 0x0f, 0x2d, 0x13, 0x09, 0x02, 0x03, 0x01, 0x01, 0x02,
+  0x09, 0x03, 0x02, 0x05, 0x04, 0x13, 0x2b, 0x05, 0x04, 0x07, 0x01, 0x0d, 0x35, 0x0e, 0x0a, 0x01,
+  0x01, 0x01, 0x01, 0x06, 0x03, 0x01, 0x03, 0x03, 0x01, 0x07, 0x03, 0x14, 0x2b, 0x04, 0x04, 0x07,
+  0x01, 0x0b, 0x3a, 0x0c, 0x08, 0x0b, 0x02, 0x02, 0x03, 0x03, 0x01, 0x07, 0x03, 0x15, 0x2b, 0x03,
+  0x04, 0x06, 0x02, 0x07, 0x3f, 0x0b, 0x08, 0x0b, 0x01, 0x03, 0x02, 0x03, 0x01, 0x09, 0x03, 0x15,
+  0x2a, 0x03, 0x03, 0x07, 0x02, 0x05, 0x42, 0x0a, 0x09, 0x0e, 0x01, 0x04, 0x01, 0x0a, 0x02, 0x16,
+  0x29, 0x02, 0x04, 0x07, 0x02, 0x03, 0x47, 0x06, 0x05, 0x01, 0x02, 0x03, 0x01, 0x10, 0x01, 0x0b,
+  0x02, 0x16, 0x29, 0x02, 0x03, 0x08, 0x02, 0x02, 0x11, 0x01, 0x38, 0x03, 0x05, 0x02, 0x01, 0x21,
+  0x02, 0x17, 0x28, 0x03, 0x01, 0x09, 0x14, 0x06, 0x1e, 0x01, 0x15, 0x02, 0x06, 0x02, 0x01, 0x14,
+  0x01, 0x0c, 0x02, 0x17, 0x28, 0x0d, 0x14, 0x07, 0x0a, 0x01, 0x07, 0x07, 0x01, 0x03, 0x17, 0x01,
+  0x06, 0x02, 0x01, 0x3a, 0x28, 0x0d, 0x15, 0x07, 0x0f, 0x09, 0x21, 0x3f, 0x27, 0x0c, 0x17, 0x07,
+  0x02, 0x01, 0x09, 0x0a, 0x22, 0x02, 0x05, 0x38, 0x27, 0x0c, 0x18, 0x0b, 0x02, 0x01, 0x01, 0x0c,
+  0x29, 0x39, 0x27, 0x0c, 0x19, 0x19, 0x27, 0x02, 0x01, 0x38, 0x28, 0x0c, 0x1a, 0x09, 0x03, 0x0b,
+  0x28, 0x3b, 0x28, 0x0c, 0x1a, 0x08, 0x05, 0x0a, 0x28, 0x3c, 0x27, 0x0c, 0x1b, 0x06, 0x06, 0x09,
+  0x25, 0x01, 0x03, 0x3c, 0x26, 0x0c, 0x1c, 0x06, 0x07, 0x08, 0x1c, 0x06, 0x01, 0x42, 0x26, 0x0c,
+  0x1c, 0x06, 0x07, 0x08, 0x1c, 0x48, 0x27, 0x0c, 0x1d, 0x05, 0x07, 0x08, 0x1d, 0x0e, 0x01, 0x38,
+  0x28, 0x0b, 0x1c, 0x06, 0x07, 0x08, 0x1d, 0x0d, 0x02, 0x38, 0x28, 0x0b, 0x14, 0x0e, 0x08, 0x09,
+  0x1c, 0x46, 0x29, 0x0a, 0x10, 0x11, 0x09, 0x09, 0x1d, 0x05, 0x01, 0x06, 0x01, 0x37, 0x2a, 0x09,
+  0x13, 0x0f, 0x28, 0x04, 0x02, 0x06, 0x02, 0x03, 0x03, 0x37, 0x2a, 0x08, 0x0a, 0x09, 0x05, 0x0a,
+  0x12, 0x0d, 0x0a, 0x10, 0x03, 0x38, 0x2a, 0x06, 0x0b, 0x0d, 0x03, 0x09, 0x0f, 0x15, 0x05, 0x10,
+  0x03, 0x37, 0x2b, 0x04, 0x01, 0x02, 0x03, 0x01, 0x06, 0x0f, 0x02, 0x07, 0x10, 0x18, 0x03, 0x0d,
+  0x06, 0x36, 0x2c, 0x02, 0x05, 0x03, 0x06, 0x10, 0x02, 0x05, 0x13, 0x19, 0x01, 0x05, 0x0c, 0x37,
+  0x2d, 0x01, 0x0e, 0x11, 0x1a, 0x1d, 0x0c, 0x37, 0x2d, 0x01, 0x07, 0x01, 0x08, 0x0e, 0x06, 0x04,
+  0x18, 0x12, 0x04, 0x01, 0x07, 0x3c, 0x2c, 0x02, 0x04, 0x05, 0x08, 0x0f, 0x01, 0x03, 0x0c, 0x01,
+  0x0e, 0x0f, 0x07, 0x02, 0x04, 0x01, 0x01, 0x3d, 0x2c, 0x01, 0x01, 0x06, 0x0b, 0x0d, 0x01, 0x03,
+  0x1d, 0x0e, 0x0f, 0x3d, 0x2b, 0x03, 0x01, 0x03, 0x06, 0x01, 0x09, 0x0e, 0x1f, 0x07, 0x13, 0x01,
+  0x01, 0x03, 0x05, 0x35, 0x2a, 0x04, 0x09, 0x02, 0x09, 0x0d, 0x0f, 0x01, 0x11, 0x04, 0x11, 0x05,
+  0x01, 0x01, 0x08, 0x33, 0x2e, 0x01, 0x09, 0x02, 0x08, 0x0d, 0x05, 0x01, 0x0a, 0x02, 0x02, 0x01,
+  0x0f, 0x03, 0x0f, 0x05, 0x0b, 0x33, 0x38, 0x02, 0x07, 0x0d, 0x06, 0x02, 0x09, 0x02, 0x01, 0x03,
+  0x10, 0x03, 0x0b, 0x02, 0x01, 0x03, 0x0d, 0x31, 0x39, 0x02, 0x06, 0x0a, 0x02, 0x02, 0x04, 0x04,
+  0x09, 0x06, 0x10, 0x06, 0x05, 0x04, 0x02, 0x02, 0x0e, 0x2f, 0x3b, 0x02, 0x06, 0x0b, 0x07, 0x03,
+  0x09, 0x08, 0x05, 0x06, 0x04, 0x0e, 0x03, 0x02, 0x0d, 0x2f, 0x3c, 0x01, 0x08, 0x03, 0x02, 0x02,
+  0x01, 0x02, 0x08, 0x02, 0x09, 0x08, 0x06, 0x17, 0x04, 0x01, 0x0d, 0x2f, 0x3c, 0x01, 0x0e, 0x05,
+  0x13, 0x04, 0x02, 0x01, 0x06, 0x16, 0x04, 0x02, 0x0d, 0x2e, 0x49, 0x07, 0x15, 0x03, 0x02, 0x01,
+  0x07, 0x13, 0x06, 0x02, 0x0d, 0x2e, 0x49, 0x03, 0x19, 0x04, 0x0a, 0x11, 0x07, 0x02, 0x0c, 0x06,
+  0x02, 0x27, 0x66, 0x03, 0x0b, 0x0e, 0x09, 0x01, 0x0b, 0x01, 0x01, 0x04, 0x03, 0x27, 0x67, 0x04,
+  0x0c, 0x09, 0x0b, 0x02, 0x0a, 0x07, 0x02, 0x27, 0x69, 0x03, 0x20, 0x02, 0x0a, 0x04, 0x01, 0x2a,
+  0x69, 0x05, 0x1f, 0x01, 0x0b, 0x2e, 0x69, 0x07, 0x1d, 0x02, 0x09, 0x30, 0x69, 0x08, 0x1c, 0x01,
+  0x09, 0x30, 0x6a, 0x09, 0x1a, 0x02, 0x06, 0x01, 0x01, 0x30, 0x57, 0x02, 0x15, 0x08, 0x16, 0x04,
+  0x07, 0x30, 0x42, 0x02, 0x11, 0x03, 0x19, 0x0a, 0x10, 0x03, 0x09, 0x30, 0x45, 0x04, 0x08, 0x04,
+  0x1e, 0x0e, 0x06, 0x05, 0x0a, 0x32, 0x47, 0x05, 0x28, 0x08, 0x18, 0x33, 0x65, 0x05, 0x0c, 0x08,
+  0x15, 0x35, 0x50, 0x01, 0x0c, 0x0f, 0x0a, 0x0c, 0x0a, 0x01, 0x02, 0x38, 0x4b, 0x01, 0x05, 0x02,
+  0x06, 0x15, 0x09, 0x0d, 0x0b, 0x38, 0x4b, 0x01, 0x07, 0x01, 0x04, 0x1b, 0x05, 0x0f, 0x02, 0x01,
+  0x05, 0x39, 0x4b, 0x01, 0x08, 0x01, 0x02, 0x1f, 0x01, 0x51, 0x53, 0x01, 0x02, 0x06, 0x01, 0x6a,
+  0x56, 0x07, 0x01, 0x1e, 0x02, 0x4a, 0x58, 0x04, 0x03, 0x1c, 0x04, 0x48, 0x58, 0x04, 0x04, 0x1c,
+  0x04, 0x48, 0x57, 0x04, 0x08, 0x18, 0x06, 0x46, 0x58, 0x04, 0x09, 0x16, 0x08, 0x44, 0x58, 0x04,
+  0x0b, 0x13, 0x0a, 0x43, 0x58, 0x04, 0x0c, 0x11, 0x0d, 0x42, 0x57, 0x05, 0x0c, 0x0b, 0x14, 0x04,
+  0x01, 0x3b, 0x57, 0x05, 0x0c, 0x0a, 0x16, 0x04, 0x02, 0x39, 0x58, 0x05, 0x0c, 0x0a, 0x16, 0x3f,
+  0x59, 0x03, 0x0f, 0x05, 0x01, 0x02, 0x16, 0x3e, 0x5a, 0x03, 0x2e, 0x04, 0x01, 0x37, 0x5a, 0x04,
+  0x2e, 0x04, 0x03, 0x01, 0x02, 0x32, 0x59, 0x04, 0x30, 0x03, 0x01, 0x05, 0x01, 0x30, 0x5a, 0x04,
+  0x30, 0x0a, 0x03, 0x2c, 0x5a, 0x05, 0x0a, 0x04, 0x23, 0x06, 0x01, 0x01, 0x04, 0x2b, 0x5b, 0x04,
+  0x09, 0x07, 0x02, 0x07, 0x12, 0x01, 0x06, 0x37, 0x5a, 0x05, 0x06, 0x18, 0x04, 0x01, 0x10, 0x04,
+  0x01, 0x30, 0x5b, 0x05, 0x04, 0x05, 0x07, 0x18, 0x07, 0x01, 0x03, 0x34, 0x5c, 0x04, 0x04, 0x05,
+  0x10, 0x14, 0x07, 0x33, 0x5d, 0x04, 0x04, 0x05, 0x12, 0x13, 0x04, 0x01, 0x02, 0x06, 0x05, 0x26,
+  0x5f, 0x02, 0x03, 0x0d, 0x02, 0x1d, 0x03, 0x09, 0x06, 0x26, 0x63, 0x06, 0x03, 0x2f, 0x01, 0x01,
+  0x05, 0x25, 0x64, 0x05, 0x03, 0x25, 0x01, 0x0a, 0x06, 0x25, 0x5b, 0x01, 0x08, 0x06, 0x03, 0x30,
+  0x06, 0x09, 0x04, 0x17, 0x5c, 0x01, 0x08, 0x05, 0x03, 0x30, 0x07, 0x23, 0x5d, 0x02, 0x06, 0x06,
+  0x02, 0x30, 0x08, 0x23, 0x5d, 0x02, 0x05, 0x06, 0x03, 0x30, 0x06, 0x25, 0x5d, 0x02, 0x0e, 0x2f,
+  0x07, 0x25, 0x5d, 0x02, 0x0d, 0x2f, 0x07, 0x26, 0x5e, 0x02, 0x0b, 0x2e, 0x08, 0x27, 0x5e, 0x3b,
+  0x07, 0x27, 0x5f, 0x3d, 0x04, 0x28, 0x60, 0x68, 0x60, 0x68, 0x61, 0x67, 0x61, 0x66, 0x63, 0x65,
+  0x64, 0x64, 0x64, 0x64, 0x65, 0x56, 0x04, 0x08, 0x66, 0x55, 0x03, 0x01, 0x01, 0x08, 0x67, 0x06,
+  0x02, 0x22, 0x01, 0x29, 0x05, 0x08, 0x67, 0x06, 0x01, 0x23, 0x02, 0x25, 0x08, 0x08, 0x68, 0x04,
+  0x02, 0x4a, 0x08, 0x08, 0x68, 0x04, 0x02, 0x4a, 0x08, 0x07, 0x6a, 0x4d, 0x09, 0x08, 0x6a, 0x4e,
+  0x07, 0x09, 0x6b, 0x4c, 0x08, 0x09, 0x6b, 0x4b, 0x08, 0x0a, 0x6c, 0x49, 0x09, 0x09, 0x6e, 0x49,
+  0x08, 0x09, 0x6e, 0x48, 0x08, 0x0a, 0x6f, 0x47, 0x05, 0x0d, 0x6f, 0x46, 0x06, 0x0d, 0x70, 0x45,
+  0x03, 0x10, 0x71, 0x45, 0x02, 0x10, 0x71, 0x45, 0x01, 0x10, 0x72, 0x56, 0x02, 0x01, 0x70, 0x55,
+  0x02, 0x01, 0x70, 0x54, 0x03, 0x02, 0x39,
+};
+const Asset dorian={dorianData, 1623, 200, 180};
+
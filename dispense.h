@@ -0,0 +1,97 @@
+/*
+ * Dispense Engine
+ */
+
+//sales queue dispense commands and a task on core 0 runs them one at a time, so back-to-back sales are
+//never lost. the servo is stopped from a one-shot timer armed for the exact run time (microseconds)
+//rather than a polling loop, so portion size doesn't depend on scheduler jitter. all hardware access
+//goes through DispenseHal, the engine itself doesn't care whether the servo and clock are real
+
+struct DispenseHal {
+  void (*start)(); //start the servo turning
+  void (*stop)(); //stop it
+  int64_t (*now)(); //clock, microseconds
+  void (*arm)(uint32_t us); //one-shot timer that calls dispenseTimerFired() us microseconds from now
+};
+
+struct DispenseCmd {
+  uint32_t runFor; //us
+  int64_t paidAt; //clock when the sale's webhook arrived, 0 for a test dispense
+};
+
+struct DispenseRecord {
+  uint32_t commanded, actual; //run time in microseconds
+};
+
+const uint8_t dispenseQueueLen=8, dispenseLogLen=16;
+const uint16_t dispenseGap=250; //ms between queued dispenses so the wheel settles
+
+DispenseHal dispenseHal;
+QueueHandle_t dispenseQueue;
+TaskHandle_t dispenseTask;
+volatile int64_t dispenseStoppedAt; //clock at stop, set by the timer before it notifies the task
+volatile bool dispenseBusy; //a dispense is running (incl. the settle gap after it)
+
+//last dispenseLogLen dispenses (ring), plus running stats of actual-commanded over all of them
+DispenseRecord dispenseLog[dispenseLogLen];
+uint32_t dispenseCount;
+int32_t dispenseErrMin, dispenseErrMax;
+int64_t dispenseErrSum;
+
+//queue a dispense of runFor microseconds for a sale paid at paidAt (dispenseHal clock), false if the
+//queue is full
+bool dispenseQueueRun(uint32_t runFor, int64_t paidAt) {
+  DispenseCmd cmd={runFor,paidAt};
+  return xQueueSend(dispenseQueue,&cmd,0)==pdTRUE;
+}
+
+//nothing queued or running. the queue is checked first: a command leaves it only after busy is set
+bool dispenseIdle() {
+  if (uxQueueMessagesWaiting(dispenseQueue)>0) return false;
+  return !dispenseBusy;
+}
+
+//called from the one-shot timer, stop first and timestamp after so the record includes the stop itself
+void dispenseTimerFired(void *) {
+  dispenseHal.stop();
+  dispenseStoppedAt=dispenseHal.now();
+  xTaskNotifyGive(dispenseTask);
+}
+
+void dispenseRecord(uint32_t commanded, uint32_t actual) {
+  int32_t err=(int32_t)(actual-commanded);
+  if (dispenseCount==0 || err<dispenseErrMin) dispenseErrMin=err;
+  if (dispenseCount==0 || err>dispenseErrMax) dispenseErrMax=err;
+  dispenseErrSum+=err;
+  dispenseLog[dispenseCount%dispenseLogLen]={commanded,actual};
+  dispenseCount++;
+}
+
+void dispenseRun( void * ) {
+  DispenseCmd cmd;
+  while (true) {
+    //busy goes up while the command is still in the queue, so dispenseIdle() never sees neither
+    if (xQueuePeek(dispenseQueue,&cmd,portMAX_DELAY)!=pdTRUE) continue;
+    dispenseBusy=true;
+    xQueueReceive(dispenseQueue,&cmd,0);
+    dispenseHal.start();
+    int64_t startedAt=dispenseHal.now();
+    if (cmd.paidAt>0 && startedAt>cmd.paidAt) latencyRecord(dispenseLatency,startedAt-cmd.paidAt);
+    dispenseHal.arm(cmd.runFor);
+    ulTaskNotifyTake(pdTRUE,portMAX_DELAY);
+    uint32_t actual=dispenseStoppedAt-startedAt;
+    dispenseRecord(cmd.runFor,actual);
+    metricRecord(servoHist,actual);
+    if (debug) Serial.printf("dispensed for %u us (commanded %u us, err min/max %d/%d us)\n",actual,cmd.runFor,dispenseErrMin,dispenseErrMax);
+    delay(dispenseGap);
+    dispenseBusy=false;
+  }
+  Serial.print("killing task");
+  vTaskDelete(NULL);
+}
+
+void dispenseInit(const DispenseHal &hal) {
+  dispenseHal=hal;
+  dispenseQueue=xQueueCreate(dispenseQueueLen,sizeof(DispenseCmd));
+  xTaskCreatePinnedToCore(dispenseRun,"dispense",4096,NULL,2,&dispenseTask,0);
+}
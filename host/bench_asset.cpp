@@ -0,0 +1,62 @@
+/*
+ * Screen Asset Benchmark (host)
+ */
+
+//draws the dorian screen image from its compressed asset (drawAsset(), what the sketch does) and from
+//the raw image2cpp bitmap in assets/dorian.h with drawInvertedBitmap() (what it used to do), and
+//compares host time per draw incl. decoding, draw calls, pixels written and the flash each takes. both
+//have to leave exactly the same frame buffer
+//
+//  bench_asset [draws=2000]
+
+#include "lnCandyESP32.ino.cpp"
+#include <chrono>
+#include <vector>
+
+namespace raw {
+#include "assets/dorian.h"
+}
+
+struct DrawCost {
+  double us;
+  uint32_t drawCalls;
+  uint64_t pixelWrites;
+};
+
+template<typename Draw>
+static DrawCost measure(uint32_t draws, Draw draw) {
+  PanelStats before=panelStats;
+  auto start=std::chrono::steady_clock::now();
+  for (uint32_t i=0; i<draws; i++) draw();
+  double us=std::chrono::duration<double,std::micro>(std::chrono::steady_clock::now()-start).count();
+  return {us/draws,(uint32_t)((panelStats.drawCalls-before.drawCalls)/draws),(panelStats.pixelWrites-before.pixelWrites)/draws};
+}
+
+static std::vector<bool> frame() {
+  std::vector<bool> f;
+  for (int16_t y=0; y<dorian.height; y++) for (int16_t x=0; x<dorian.width; x++) f.push_back(display.pixel(x,y));
+  return f;
+}
+
+int main(int argc, char **argv) {
+  uint32_t draws=(argc>1) ? atoi(argv[1]) : 2000;
+  display.setRotation(1);
+
+  display.fillScreen(GxEPD_WHITE);
+  drawAsset(dorian,0,0,0,GxEPD_BLACK);
+  std::vector<bool> decoded=frame();
+  display.fillScreen(GxEPD_WHITE);
+  display.drawInvertedBitmap(0,0,raw::dorian,200,180,GxEPD_BLACK);
+  if (frame()!=decoded) {
+    printf("FAIL: the asset doesn't draw the same image as the raw bitmap\n");
+    hostExit(1);
+  }
+
+  DrawCost bitmap=measure(draws,[]() { display.drawInvertedBitmap(0,0,raw::dorian,200,180,GxEPD_BLACK); });
+  DrawCost asset=measure(draws,[]() { drawAsset(dorian,0,0,0,GxEPD_BLACK); });
+  printf("dorian %ux%u, %u draws each\n",dorian.width,dorian.height,draws);
+  printf("%-22s %12s %12s %14s %12s\n","","us/draw","draw calls","pixel writes","flash bytes");
+  printf("%-22s %12.1f %12u %14llu %12zu\n","raw bitmap",bitmap.us,bitmap.drawCalls,(unsigned long long)bitmap.pixelWrites,sizeof(raw::dorian));
+  printf("%-22s %12.1f %12u %14llu %12zu\n","run-length asset",asset.us,asset.drawCalls,(unsigned long long)asset.pixelWrites,(size_t)dorian.size+sizeof(Asset));
+  hostExit(0);
+}
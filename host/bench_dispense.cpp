@@ -0,0 +1,130 @@
+/*
+ * Dispense Timing Simulation (host)
+ */
+
+//runs the sketch's dispense engine (dispense.h) against a DispenseHal whose clock is simulated: the
+//bench owns time, and when the engine arms its one-shot the bench moves the clock to the deadline plus
+//a wake-up latency drawn from a model of the ESP32 (esp_timer task dispatch, and now and then a WiFi
+//interrupt burst on core 0) and fires the timer. the old way of stopping the servo, a priority 0 task
+//polling millis() every 1 ms tick, is simulated with the same latency model, and the two
+//actual-commanded run time histograms are printed side by side. meanwhile another thread keeps asking
+//dispenseIdle(), which must never say idle while a command is waiting to be started
+//
+//  bench_dispense [dispenses=2000]
+
+#include "lnCandyESP32.ino.cpp"
+#include <algorithm>
+#include <thread>
+
+static std::atomic<int64_t> simNow;
+static std::atomic<bool> armed, running;
+static std::atomic<uint32_t> armedFor;
+
+static void simStart() { running=true; }
+static void simStop() { running=false; }
+static int64_t simClock() { return simNow; }
+static void simArm(uint32_t us) { armedFor=us; armed=true; }
+
+//wake-up latency model, us: dispatch of a ready higher priority task, plus a WiFi burst 2% of the time
+static uint64_t rng=0x243F6A8885A308D3ull;
+static uint32_t rnd() {
+  rng^=rng<<13; rng^=rng>>7; rng^=rng<<17;
+  return (uint32_t)rng;
+}
+static double uniform() { return rnd()/4294967296.0; }
+static int64_t wakeLatency() {
+  int64_t us=15-10*log(1-uniform());
+  if (rnd()%100<2) us+=rnd()%500;
+  return us;
+}
+
+//the stopServo task before the dispense engine: servoStartedAt=millis() at the sale, then every tick
+//the task wakes (late by the same latency model) and stops the servo once millis() has moved on runFor ms
+static int32_t pollingError(uint32_t runForMs) {
+  int64_t t0=(int64_t)(uniform()*1e9);
+  int64_t stamp=t0/1000;
+  for (int64_t tick=stamp+1; ; tick++) {
+    int64_t woke=tick*1000+wakeLatency();
+    if (woke/1000>=stamp+runForMs) return (int32_t)(woke-t0-(int64_t)runForMs*1000);
+  }
+}
+
+static const int32_t bounds[]={-1000,-500,-250,0,25,50,100,250,500,1000};
+static const uint8_t bins=sizeof(bounds)/sizeof(bounds[0])+1;
+
+static void histAdd(uint32_t *h, int32_t err) {
+  uint8_t i=0;
+  while (i<bins-1 && err>=bounds[i]) i++;
+  h[i]++;
+}
+
+int main(int argc, char **argv) {
+  uint32_t dispenses=(argc>1) ? atoi(argv[1]) : 2000;
+  hostTimeScale=0; //the settle gap after each dispense is a delay(), nothing to wait for here
+  dispenseInit({simStart,simStop,simClock,simArm});
+
+  //odd while a command is queued and not yet turning the servo, the window dispenseIdle() used to get wrong
+  std::atomic<bool> watching{true};
+  std::atomic<uint32_t> window{0}, idleInWindow{0};
+  std::thread watcher([&]() {
+    uint32_t caught=0;
+    while (watching) {
+      uint32_t w=window;
+      if (w%2==0 || w==caught) continue;
+      bool idle=dispenseIdle();
+      if (idle && window==w) {
+        caught=w;
+        idleInWindow++;
+      }
+    }
+  });
+
+  uint32_t engine[bins]={}, polling[bins]={};
+  std::vector<int64_t> engineErrs, pollingErrs;
+  for (uint32_t i=0; i<dispenses; i++) {
+    simNow+=1000000+rnd()%1000;
+    uint32_t before=dispenseCount;
+    window++;
+    dispenseQueueRun((uint32_t)servoRunFor*1000,0);
+    while (!armed) hostSleepUs(0);
+    window++;
+    armed=false;
+    simNow+=armedFor+wakeLatency();
+    dispenseTimerFired(NULL);
+    while (dispenseCount==before || !dispenseIdle()) hostSleepUs(0);
+    if (running) {
+      printf("FAIL: servo still running after dispense %u\n",i);
+      hostExit(1);
+    }
+    DispenseRecord &r=dispenseLog[(dispenseCount-1)%dispenseLogLen];
+    int32_t err=(int32_t)(r.actual-r.commanded);
+    engineErrs.push_back(err);
+    histAdd(engine,err);
+    err=pollingError(servoRunFor);
+    pollingErrs.push_back(err);
+    histAdd(polling,err);
+  }
+  watching=false;
+  watcher.join();
+
+  printf("%u dispenses of %u ms, actual-commanded run time\n",dispenses,servoRunFor);
+  printf("%-12s %10s %10s\n","error us","engine","polling");
+  for (uint8_t i=0; i<bins; i++) {
+    char label[24];
+    if (i==0) snprintf(label,sizeof(label),"< %d",bounds[0]);
+    else if (i==bins-1) snprintf(label,sizeof(label),">= %d",bounds[bins-2]);
+    else snprintf(label,sizeof(label),"%d-%d",bounds[i-1],bounds[i]-1);
+    printf("%-12s %10u %10u\n",label,engine[i],polling[i]);
+  }
+  std::sort(engineErrs.begin(),engineErrs.end());
+  std::sort(pollingErrs.begin(),pollingErrs.end());
+  printf("%-12s %10lld %10lld\n","p50",(long long)engineErrs[engineErrs.size()/2],(long long)pollingErrs[pollingErrs.size()/2]);
+  printf("%-12s %10lld %10lld\n","p99",(long long)engineErrs[engineErrs.size()*99/100],(long long)pollingErrs[pollingErrs.size()*99/100]);
+  printf("%-12s %10lld %10lld\n","max",(long long)engineErrs.back(),(long long)pollingErrs.back());
+  if (dispenseErrMin!=engineErrs.front() || dispenseErrMax!=engineErrs.back()) {
+    printf("FAIL: engine's own min/max %d/%d us don't match the simulation\n",dispenseErrMin,dispenseErrMax);
+    hostExit(1);
+  }
+  printf("dispenseIdle() said idle while a command was queued: in %u dispenses\n",idleInWindow.load());
+  hostExit(idleInWindow>0 ? 1 : 0);
+}
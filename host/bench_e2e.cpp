@@ -0,0 +1,83 @@
+/*
+ * End-to-End Sale Latency (host)
+ */
+
+//customers buy candy one after another from the sketch, running against the fake LNbits. each pays
+//the QR code on screen thinkMs after it went up, so with a small think time the next payment lands
+//while the last sale is still dispensing. payment->dispense is timed from the webhook going out to the
+//servo starting, payment->next QR from the webhook to the next invoice's QR code finishing its
+//refresh. p50/p99 are reported as seen from outside and as the sketch measured them (latency.h),
+//which have to agree while the sketch still holds every sale
+//
+//  bench_e2e [customers=20] [thinkMs=400] [lnbitsMs=150]
+
+#include "lnCandyESP32.ino.cpp"
+#include "harness.h"
+
+int main(int argc, char **argv) {
+  uint32_t customers=(argc>1) ? atoi(argv[1]) : 20, thinkMs=(argc>2) ? atoi(argv[2]) : 400;
+  fakeLnbitsLatencyMs=(argc>3) ? atoi(argv[3]) : 150;
+  harnessBoot();
+
+  HarnessQR qr;
+  if (!harnessWaitQR(0,qr,30000)) {
+    printf("FAIL: no QR code 30 s after boot\n");
+    hostExit(1);
+  }
+  std::vector<int64_t> paidAt;
+  uint32_t failed=0;
+  for (uint32_t i=0; i<customers; i++) {
+    hostSleepUs((int64_t)thinkMs*1000);
+    int64_t sent;
+    int status=fakeLnbitsPay(qr.hash,&sent);
+    if (status!=200) {
+      printf("customer %u: webhook answered %d\n",i+1,status);
+      failed++;
+      continue;
+    }
+    paidAt.push_back(sent);
+    if (!harnessWaitQR(qr.seq,qr,30000)) {
+      printf("FAIL: no new QR code 30 s after sale %u\n",i+1);
+      hostExit(1);
+    }
+  }
+  //every sale is queued, so the servo has to start once per sale, in order
+  if (!harnessWaitServo(paidAt.size(),paidAt.size()*2000+5000)) {
+    printf("FAIL: %zu sales, %zu dispenses\n",paidAt.size(),harnessServoStarts.size());
+    hostExit(1);
+  }
+  //the dispense task records its sample just after starting the servo
+  for (uint16_t i=0; i<1000 && dispenseLatency.count<paidAt.size(); i++) hostSleepUs(1000);
+
+  std::vector<int64_t> toDispense, toQR;
+  for (size_t i=0; i<paidAt.size(); i++) {
+    toDispense.push_back(harnessServoStarts[i]-paidAt[i]);
+    HarnessQR next;
+    if (harnessQRAfter(paidAt[i],next)) toQR.push_back(next.at-paidAt[i]);
+  }
+
+  FakeLnbitsStats lnbits=fakeLnbitsStats();
+  printf("%u customers, %u ms think time, LNbits answers in %u ms\n",customers,thinkMs,(uint32_t)fakeLnbitsLatencyMs);
+  harnessPrintLatency("payment->dispense",toDispense);
+  harnessPrintLatency("payment->next QR",toQR);
+  printf("sketch's own (last %u): payment->dispense p50 %.1f ms p99 %.1f ms, payment->next QR p50 %.1f ms p99 %.1f ms\n",
+    saleLatencyLen,latencyPercentile(dispenseLatency,50)/1000.0,latencyPercentile(dispenseLatency,99)/1000.0,latencyPercentile(qrLatency,50)/1000.0,latencyPercentile(qrLatency,99)/1000.0);
+  printf("LNbits: %u invoices, %u TLS connections; panel: %u full + %u partial refreshes\n",lnbits.invoices,lnbits.connections,panelStats.fullRefreshes,panelStats.partialRefreshes);
+  //with every sale still in the sketch's rings both sides rank the same sales, only the clocks'
+  //start and stop points differ (webhook sent vs parsed, servo started vs sample recorded)
+  if (paidAt.size()<=saleLatencyLen) {
+    int64_t own[]={latencyPercentile(dispenseLatency,50),latencyPercentile(dispenseLatency,99),latencyPercentile(qrLatency,50),latencyPercentile(qrLatency,99)};
+    int64_t outside[]={harnessPercentile(toDispense,50),harnessPercentile(toDispense,99),harnessPercentile(toQR,50),harnessPercentile(toQR,99)};
+    for (uint8_t i=0; i<4; i++) {
+      if (llabs(own[i]-outside[i])>20000) {
+        printf("FAIL: sketch's own and outside percentiles differ by more than 20 ms\n");
+        hostExit(1);
+      }
+    }
+  }
+  if (failed>0 || dispenseLatency.count!=paidAt.size() || qrLatency.count!=paidAt.size()) {
+    printf("FAIL: %u payments refused, sketch timed %u dispenses and %u QR codes for %zu sales\n",failed,dispenseLatency.count,qrLatency.count,paidAt.size());
+    hostExit(1);
+  }
+  hostExit(0);
+}
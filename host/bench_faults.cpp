@@ -0,0 +1,103 @@
+/*
+ * LNbits Fault Injection (host)
+ */
+
+//takes LNbits down while the machine is selling and checks that loop() keeps serving. for each kind
+//of outage (503s, requests that hang, connections closed without an answer) customers first empty the
+//invoice pool, then for outageMs the machine is probed every 100 ms with a webhook for an unknown
+//invoice, which loop() has to answer with a 400, and the panel refreshes are counted (the backoff
+//progress bar must stay rate limited, and every partial refresh has to count towards the next full
+//one, or ghosting builds up). then LNbits comes back, and time to recovery is from then to
+//the next QR code on screen
+//
+//  bench_faults [outageMs=15000]
+
+#include "lnCandyESP32.ino.cpp"
+#include "harness.h"
+
+static const char unknownHash[]="0000000000000000000000000000000000000000000000000000000000000000";
+
+//partial refreshes since the last full one as the panel saw them, against the sketch's own count
+static uint8_t panelRun;
+static uint32_t uncounted;
+
+static void refreshed(bool full, int16_t x, int16_t y, int16_t w, int16_t h) {
+  if (full) {
+    panelRun=0;
+  } else {
+    //the sketch counts this one after the refresh returns, so it's one behind the panel here
+    if (partialRefreshes!=panelRun) uncounted++;
+    panelRun=partialRefreshes+1;
+  }
+  harnessRefreshed(full,x,y,w,h);
+}
+
+struct Outage {
+  FakeLnbitsFault fault;
+  const char *name;
+};
+
+int main(int argc, char **argv) {
+  uint32_t outageMs=(argc>1) ? atoi(argv[1]) : 15000;
+  const Outage outages[]={{FAKE_5XX,"503"},{FAKE_HANG,"hang"},{FAKE_CLOSE,"close"}};
+  harnessBoot();
+  panelOnRefresh=refreshed;
+
+  HarnessQR qr;
+  if (!harnessWaitQR(0,qr,30000)) {
+    printf("FAIL: no QR code 30 s after boot\n");
+    hostExit(1);
+  }
+  printf("outage of %u ms, webhook probe every 100 ms\n",outageMs);
+  printf("%-6s %8s %10s %10s %10s %12s %8s %12s\n","fault","probes","p50 ms","p99 ms","max ms","refreshes/s","retries","recovery s");
+  uint32_t failed=0;
+  for (const Outage &outage : outages) {
+    for (uint16_t i=0; i<3000 && poolFree()>0; i++) hostSleepUs(10000);
+    harnessWaitQR(0,qr,0);
+    uint32_t retries=invoiceRetriesTotal;
+    fakeLnbitsFault=outage.fault;
+
+    //sell until the pool is empty and no new QR code comes up
+    while (true) {
+      if (fakeLnbitsPay(qr.hash)!=200) break;
+      if (!harnessWaitQR(qr.seq,qr,3000)) break;
+    }
+
+    std::vector<int64_t> probes;
+    uint32_t wrong=0;
+    PanelStats panelBefore=panelStats;
+    int64_t start=hostNow();
+    while (hostNow()-start<(int64_t)outageMs*1000) {
+      int64_t sent;
+      int status=fakeLnbitsPay(unknownHash,&sent);
+      {
+        HostHeapBypass bypass;
+        probes.push_back(hostNow()-sent);
+      }
+      if (status!=400) wrong++;
+      hostSleepUs(100000);
+    }
+    double seconds=(hostNow()-start)/1e6;
+    uint32_t refreshes=(panelStats.fullRefreshes-panelBefore.fullRefreshes)+(panelStats.partialRefreshes-panelBefore.partialRefreshes);
+
+    //LNbits is back: the next QR code should follow within the current backoff (plus a hung request)
+    fakeLnbitsFault=FAKE_OK;
+    int64_t backAt=hostNow();
+    uint32_t waitMs=(uint32_t)invoiceRetryWait*1000+lnbitsTimeout+5000;
+    bool recovered=harnessWaitQR(qr.seq,qr,waitMs);
+    char recovery[16]="never";
+    if (recovered) snprintf(recovery,sizeof(recovery),"%.2f",(qr.at-backAt)/1e6);
+    HostHeapBypass bypass;
+    printf("%-6s %8zu %10.1f %10.1f %10.1f %12.2f %8u %12s\n",outage.name,probes.size(),harnessPercentile(probes,50)/1000.0,harnessPercentile(probes,99)/1000.0,
+      harnessPercentile(probes,100)/1000.0,refreshes/seconds,invoiceRetriesTotal-retries,recovery);
+    if (wrong>0) printf("  %u probes not answered with a 400\n",wrong);
+    if (uncounted>0) printf("  %u partial refreshes not counted towards the next full one\n",uncounted);
+    if (!recovered || wrong>0 || refreshes/seconds>1000.0/progressRedrawEvery+0.5 || uncounted>0) failed++;
+    uncounted=0;
+  }
+  if (failed>0) {
+    printf("FAIL: %u outages not handled\n",failed);
+    hostExit(1);
+  }
+  hostExit(0);
+}
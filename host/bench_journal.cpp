@@ -0,0 +1,235 @@
+/*
+ * Sales Journal Power-Cut Test (host)
+ */
+
+//runs journal.h on the simulated NOR flash and pulls the power in the places that matter: partway
+//through a record in the middle of a sector, right after the next sector was erased and before
+//anything was written to it, and on the wrap, where the head ends up in a lower sector than the
+//older records. then a random sweep. after every cut the machine "reboots" (RAM state gone,
+//journalBegin() again) and the journal is checked against everything that was appended:
+//
+//  - every sale whose journalFlush() returned is still there, unless its sector has been erased since
+//    (the ring keeps the newest 960-1024 records, less a slot for every record a cut tore)
+//  - every valid record on flash is a sale that was appended, byte for byte
+//  - numbering carries on after the newest record and the next write goes to a blank slot
+//  - journalNext() (what GET /journal reads) returns exactly the valid records, in seq order
+//
+//then write amplification (bytes programmed + erased per byte of records) and commit latency (the
+//modelled flash time of one journalFlush()) for a few batch sizes
+//
+//  bench_journal [sweep=2000]
+
+#include <Arduino.h>
+#include "journal.h"
+#include <algorithm>
+#include <map>
+#include <vector>
+
+static const uint16_t ringKeeps=15*journalRecsPerSector; //sectors-1 full ones, without torn slots
+
+//seq -> what was appended, incl. what never made it, and for committed sales the sector it went to
+//and that sector's erase count right after: the sale may only be gone once the sector was erased again
+struct Sale {
+  JournalRecord rec;
+  int16_t sector;
+  uint32_t wear;
+};
+static std::map<uint32_t,Sale> appended;
+static uint32_t committed; //highest seq whose flush returned
+static uint32_t rng=0x9E3779B9;
+
+static uint32_t rnd() {
+  rng^=rng<<13; rng^=rng>>17; rng^=rng<<5;
+  return rng;
+}
+
+static void fail(const char *scenario, const char *what, uint32_t seq) {
+  printf("FAIL: %s: %s (sale #%u)\n",scenario,what,seq);
+  hostExit(1);
+}
+
+static void sale() {
+  char hash[65];
+  for (uint8_t i=0; i<64; i++) hash[i]="0123456789abcdef"[rnd()%16];
+  hash[64]=0;
+  uint32_t seq=journalAppend(1700000000+rnd()%1000000,hash,25);
+  appended[seq]={journalBatch[journalPending-1],-1,0};
+}
+
+//append and flush a batch, false if the power went
+static bool batch(uint8_t n) {
+  try {
+    for (uint8_t i=0; i<n; i++) sale();
+    uint32_t last=journalNextSeq-1;
+    uint16_t sector=journalSector, slot=journalSlot;
+    journalFlush(true);
+    for (uint32_t seq=last-n+1; seq<=last; seq++) {
+      if (slot>=journalRecsPerSector) {
+        sector=(sector+1)%journalSectors;
+        slot=0;
+      }
+      slot++;
+      appended[seq].sector=sector;
+      appended[seq].wear=hostFlashSectorWear(sector);
+    }
+    committed=last;
+    return true;
+  } catch (const HostPowerCut &) {
+    return false;
+  }
+}
+
+//RAM is gone: boot from flash and check it against what was appended
+static void reboot(const char *scenario) {
+  hostFlashNoCut();
+  journalPart=NULL;
+  journalSectors=journalSector=journalSlot=0;
+  journalNextSeq=0;
+  journalPending=0;
+  uint32_t last=journalBegin(0);
+
+  if (last<committed) fail(scenario,"newest record older than the last committed sale",committed);
+  if (journalNextSeq!=last+1) fail(scenario,"numbering doesn't carry on after the newest record",last);
+  //sales after the newest record never made it, their numbers will be used again
+  appended.erase(appended.upper_bound(last),appended.end());
+  if (last>2*ringKeeps) appended.erase(appended.begin(),appended.lower_bound(last-2*ringKeeps)); //long since lapped
+  committed=last;
+
+  std::vector<bool> seen(last+1,false);
+  JournalRecord rec;
+  for (uint16_t sector=0; sector<journalSectors; sector++) {
+    for (uint16_t slot=0; slot<journalRecsPerSector; slot++) {
+      esp_partition_read(journalPart,journalOffset(sector,slot),&rec,sizeof(rec));
+      if (!journalValid(rec)) continue;
+      auto it=appended.find(rec.seq);
+      if (it==appended.end() || memcmp(&it->second.rec,&rec,sizeof(rec))!=0) fail(scenario,"record on flash that wasn't appended",rec.seq);
+      if (seen[rec.seq]) fail(scenario,"sale recorded twice",rec.seq);
+      seen[rec.seq]=true;
+    }
+  }
+  for (auto &it : appended) {
+    const Sale &s=it.second;
+    if (!seen[it.first] && s.sector>=0 && hostFlashSectorWear(s.sector)==s.wear) fail(scenario,"committed sale missing",it.first);
+  }
+  uint32_t at=0, walked=0, prev=0;
+  while (journalNext(at,rec)) {
+    if (rec.seq>last || !seen[rec.seq]) fail(scenario,"read back a record that isn't on flash",rec.seq);
+    if (walked>0 && rec.seq<=prev) fail(scenario,"records read back out of order",rec.seq);
+    prev=rec.seq;
+    walked++;
+  }
+  if (walked!=(uint32_t)std::count(seen.begin(),seen.end(),true)) fail(scenario,"reading back skipped records",walked);
+  if (journalSlot<journalRecsPerSector) {
+    esp_partition_read(journalPart,journalOffset(journalSector,journalSlot),&rec,sizeof(rec));
+    if (!journalBlank(rec)) fail(scenario,"next write would go to a slot that isn't blank",journalNextSeq);
+  }
+}
+
+static void fresh() {
+  hostFlashErase();
+  appended.clear();
+  committed=0;
+  journalPart=NULL;
+  journalBegin(0);
+}
+
+//fill until the next record goes to sector/slot, in batches of up to 8
+static void fillTo(uint16_t sector, uint16_t slot, uint16_t laps) {
+  uint32_t target=(uint32_t)laps*journalSectors*journalRecsPerSector+(uint32_t)sector*journalRecsPerSector+slot;
+  while (committed<target) batch(std::min<uint32_t>(target-committed,1+rnd()%journalBatchMax));
+}
+
+//what the flush would touch, as the cut budget counts it: one per byte programmed, one per erase
+static uint32_t cutInRecord(uint8_t record, uint8_t byte) { return record*sizeof(JournalRecord)+byte; }
+
+int main(int argc, char **argv) {
+  uint32_t sweeps=(argc>1) ? atoi(argv[1]) : 2000;
+  flashModelTiming=false;
+
+  //torn record mid-sector: the flush of 4 records loses power 37 bytes into the third
+  fresh();
+  fillTo(3,20,0);
+  hostFlashCutAfter(cutInRecord(2,37));
+  if (batch(4)) fail("torn record","power cut didn't happen",0);
+  reboot("torn record");
+  if (committed!=3*journalRecsPerSector+20+2) fail("torn record","the two records before the torn one are gone",committed);
+  fillTo(5,0,0);
+  reboot("torn record, written on");
+  printf("%-36s ok, resumed at %u/%u\n","torn record mid-sector",journalSector,journalSlot);
+
+  //the sector is full, the flush erases the next one and the power goes before a byte is written
+  fresh();
+  fillTo(6,journalRecsPerSector,0);
+  uint32_t wear=hostFlashSectorWear(7);
+  hostFlashCutAfter(1);
+  if (batch(1)) fail("cut after erase","power cut didn't happen",0);
+  if (hostFlashSectorWear(7)!=wear+1) fail("cut after erase","the next sector wasn't erased before the cut",0);
+  reboot("cut after erase");
+  fillTo(8,3,0);
+  reboot("cut after erase, written on");
+  printf("%-36s ok, sector 7 erased %u times\n","cut after erasing the next sector",hostFlashSectorWear(7));
+
+  //interrupted erase of the next sector, which still held records from the previous lap
+  fresh();
+  fillTo(2,journalRecsPerSector,1);
+  hostFlashCutAfter(0);
+  if (batch(3)) fail("interrupted erase","power cut didn't happen",0);
+  reboot("interrupted erase");
+  fillTo(4,0,1);
+  reboot("interrupted erase, written on");
+  printf("%-36s ok\n","cut during the erase");
+
+  //wrap-around: the head is in sector 2 and sectors 3-15 still hold the lap before, with lower numbers
+  fresh();
+  fillTo(2,10,1);
+  reboot("wrap-around");
+  if (journalSector!=2 || journalSlot!=10) fail("wrap-around","didn't resume after the newest record",journalNextSeq);
+  //and the wrap itself, cut right after erasing sector 0 again
+  fillTo(journalSectors-1,journalRecsPerSector,1);
+  hostFlashCutAfter(1);
+  if (batch(2)) fail("wrap","power cut didn't happen",0);
+  reboot("wrap, cut after erasing sector 0");
+  fillTo(1,0,2);
+  reboot("wrap, written on");
+  uint32_t kept=0;
+  JournalRecord rec;
+  for (uint32_t off=0; off<journalPart->size; off+=sizeof(rec)) {
+    esp_partition_read(journalPart,off,&rec,sizeof(rec));
+    if (journalValid(rec)) kept++;
+  }
+  printf("%-36s ok, %u records kept\n","wrap-around",kept);
+
+  //random sweep: random batch sizes, the power cut anywhere in a flush
+  fresh();
+  uint32_t cuts=0;
+  for (uint32_t i=0; i<sweeps; i++) {
+    for (uint32_t n=rnd()%40; n>0; n--) batch(1+rnd()%journalBatchMax);
+    hostFlashCutAfter(rnd()%(journalBatchMax*sizeof(JournalRecord)+2));
+    if (!batch(1+rnd()%journalBatchMax)) cuts++;
+    reboot("random sweep");
+  }
+  printf("%-36s ok, %u cuts, %u laps of the ring\n","random power cuts",cuts,committed/(journalSectors*journalRecsPerSector));
+
+  //write amplification and commit latency
+  printf("\n%-8s %10s %10s %14s %14s %14s\n","batch","sales","WA","commit p50 ms","commit p99 ms","wear min/max");
+  for (uint8_t size : {1,4,8}) {
+    fresh();
+    std::vector<int64_t> commits;
+    const uint32_t sales=10000;
+    FlashStats before=flashStats;
+    for (uint32_t done=0; done<sales; done+=size) {
+      uint64_t busy=flashStats.busyUs;
+      batch(size);
+      commits.push_back(flashStats.busyUs-busy);
+    }
+    double wa=(double)(flashStats.bytesProgrammed-before.bytesProgrammed+(flashStats.sectorErases-before.sectorErases)*journalSectorSize)/(committed*sizeof(JournalRecord));
+    std::sort(commits.begin(),commits.end());
+    uint32_t wearMin=UINT32_MAX, wearMax=0;
+    for (uint16_t s=0; s<journalSectors; s++) {
+      wearMin=std::min(wearMin,hostFlashSectorWear(s));
+      wearMax=std::max(wearMax,hostFlashSectorWear(s));
+    }
+    printf("%-8u %10u %10.2f %14.2f %14.2f %7u/%u\n",size,committed,wa,commits[commits.size()/2]/1000.0,commits[commits.size()*99/100]/1000.0,wearMin,wearMax);
+  }
+  hostExit(0);
+}
@@ -0,0 +1,49 @@
+/*
+ * Metrics Recording Benchmark (host)
+ */
+
+//what metricRecord() costs per event, with durations spread over every bucket incl. +Inf (the worst
+//case walks all twelve bounds). it runs on the hot paths, so it has to stay well under a microsecond.
+//also the time to render a histogram for a /metrics scrape
+//
+//  bench_metrics [events=10000000]
+
+#include <Arduino.h>
+#include "metrics.h"
+#include <chrono>
+#include <vector>
+
+Histogram benchHist={"lncandy_bench_seconds","metricRecord benchmark",{},0,0};
+
+int main(int argc, char **argv) {
+  uint32_t events=(argc>1) ? atoi(argv[1]) : 10000000;
+  std::vector<uint32_t> durations(4096);
+  uint32_t rng=1;
+  for (uint32_t &d : durations) {
+    rng=rng*1664525+1013904223;
+    d=(rng>>8)%8000000;
+  }
+
+  auto start=std::chrono::steady_clock::now();
+  for (uint32_t i=0; i<events; i++) metricRecord(benchHist,durations[i&4095]);
+  double ns=std::chrono::duration<double,std::nano>(std::chrono::steady_clock::now()-start).count()/events;
+  if (benchHist.count!=events) {
+    printf("FAIL: %u events recorded, expected %u\n",benchHist.count,events);
+    hostExit(1);
+  }
+
+  static char page[6144];
+  const uint32_t scrapes=10000;
+  size_t len=0;
+  start=std::chrono::steady_clock::now();
+  for (uint32_t i=0; i<scrapes; i++) len=metricsHistogram(page,sizeof(page),0,benchHist);
+  double scrapeUs=std::chrono::duration<double,std::micro>(std::chrono::steady_clock::now()-start).count()/scrapes;
+
+  printf("metricRecord: %.1f ns per event (%u events)\n",ns,events);
+  printf("one histogram on /metrics: %zu bytes, %.2f us to render\n",len,scrapeUs);
+  if (ns>=1000) {
+    printf("FAIL: recording costs %.1f ns per event, must be under 1 us\n",ns);
+    hostExit(1);
+  }
+  hostExit(0);
+}
@@ -0,0 +1,131 @@
+/*
+ * OTA Upload Test (host)
+ */
+
+//uploads a made-up app image to the running sketch's /update the way the browser does (multipart, in
+//HTTP_UPLOAD_BUFLEN chunks), plain and gzip'd with zlib, through the inflate and the double-buffered
+//flash writer into the simulated OTA partition (flash time modelled). checks what ended up in the
+//partition and reports end-to-end and flash MB/s as the sketch measured them, plus the peak heap the
+//update took. the gzip'd upload also runs with tinflHostLookahead=4, where the ROM's inflate swallows
+//half the gzip trailer, and then the ways it has to fail: wrong sha256, wrong size in the trailer,
+//gzip cut short, and the connection dropped mid-upload (which must leave nothing allocated)
+//
+//  bench_ota [imageKB=1024] [networkKBps=0, unlimited]
+
+#include "lnCandyESP32.ino.cpp"
+#include "harness.h"
+#include <zlib.h>
+#include <openssl/sha.h>
+
+static std::vector<uint8_t> makeImage(size_t len) {
+  //an app image header, then code-like data: runs of repeated words and some noise, compresses ~2:1
+  std::vector<uint8_t> img(len);
+  uint32_t rng=7;
+  for (size_t i=0; i<len; i++) {
+    rng=rng*1103515245+12345;
+    img[i]=((rng>>16)%3==0) ? (uint8_t)(rng>>24) : (uint8_t)("\x00\x00\x00\x00\x12\xc1\x36\x41\x22\xa0\x0c\x1d\xf0"[i%13]);
+  }
+  img[0]=0xE9;
+  return img;
+}
+
+static std::vector<uint8_t> gzip(const std::vector<uint8_t> &in) {
+  z_stream z={};
+  deflateInit2(&z,9,Z_DEFLATED,15+16,9,Z_DEFAULT_STRATEGY);
+  gz_header header={};
+  header.name=(Bytef*)"lnCandyESP32.ino.bin";
+  deflateSetHeader(&z,&header);
+  std::vector<uint8_t> out(deflateBound(&z,in.size())+64);
+  z.next_in=(Bytef*)in.data(); z.avail_in=in.size();
+  z.next_out=out.data(); z.avail_out=out.size();
+  deflate(&z,Z_FINISH);
+  out.resize(z.total_out);
+  deflateEnd(&z);
+  return out;
+}
+
+static std::string shaHex(const std::vector<uint8_t> &data) {
+  uint8_t sha[32];
+  SHA256(data.data(),data.size(),sha);
+  char hex[65];
+  for (uint8_t i=0; i<32; i++) sprintf(hex+i*2,"%02x",sha[i]);
+  return hex;
+}
+
+struct Upload {
+  const char *name;
+  const std::vector<uint8_t> *data;
+  uint8_t lookahead;
+  bool badSha;
+  size_t abortAt;
+  const char *expect; //NULL for OK, else what the FAIL has to say
+};
+
+int main(int argc, char **argv) {
+  size_t imageLen=((argc>1) ? atoi(argv[1]) : 1024)*1024;
+  uint32_t networkKBps=(argc>2) ? atoi(argv[2]) : 0;
+  harnessBoot();
+  HarnessQR qr;
+  if (!harnessWaitQR(0,qr,30000)) {
+    printf("FAIL: no QR code 30 s after boot\n");
+    hostExit(1);
+  }
+  for (uint16_t i=0; i<3000 && poolFree()>0; i++) hostSleepUs(1000);
+
+  std::vector<uint8_t> image=makeImage(imageLen), gz=gzip(image);
+  std::vector<uint8_t> badSize=gz, shortGz(gz.begin(),gz.end()-100);
+  badSize[badSize.size()-1]^=0x01;
+  std::string sha=shaHex(image);
+  const Upload uploads[]={
+    {"plain .bin",&image,0,false,(size_t)-1,NULL},
+    {".gz",&gz,0,false,(size_t)-1,NULL},
+    {".gz, inflate look-ahead 4",&gz,4,false,(size_t)-1,NULL},
+    {".gz, wrong sha256",&gz,4,true,(size_t)-1,"sha256 mismatch"},
+    {".gz, wrong size in trailer",&badSize,4,false,(size_t)-1,"gzip size mismatch"},
+    {".gz, cut short",&shortGz,0,false,(size_t)-1,"gzip data ends early"},
+    {".gz, connection dropped",&gz,0,false,gz.size()/2,"upload aborted"},
+    {".gz after the drop",&gz,4,false,(size_t)-1,NULL},
+  };
+
+  printf("%zu KB image, %zu KB gzip'd, network %s\n",image.size()/1024,gz.size()/1024,networkKBps ? (std::to_string(networkKBps)+" KB/s").c_str() : "unlimited");
+  printf("%-28s %-24s %10s %10s %12s\n","upload","result","e2e MB/s","flash MB/s","peak heap");
+  uint32_t failed=0;
+  hostDeviceThread(); //uploads are handled here, on the device the loop task runs the handler
+  for (const Upload &u : uploads) {
+    tinflHostLookahead=u.lookahead;
+    std::string uri;
+    {
+      HostHeapBypass bypass;
+      uri="/update?sha256="+(u.badSha ? std::string(64,'0') : sha);
+    }
+    //the upload arrives no faster than the network, chunk by chunk
+    int64_t start=hostNow();
+    std::function<void(size_t)> pace=nullptr;
+    if (networkKBps>0) pace=[&](size_t at) { hostSleepUs(start+(int64_t)at*1000000/(networkKBps*1024)-hostNow()); };
+    hostHeapResetCounts();
+    HostHeapStats before=hostHeapStats();
+    int code=ota.hostUpload(uri.c_str(),u.data==&image ? "lnCandyESP32.ino.bin" : "lnCandyESP32.ino.bin.gz",u.data->data(),u.data->size(),pace,u.abortAt).code;
+    HostHeapStats after=hostHeapStats();
+    HostHeapBypass bypass;
+    std::string result=otaResult;
+    double e2e=0, flash=0;
+    size_t at=result.find('\n');
+    if (result.rfind("OK",0)==0 && at!=std::string::npos) sscanf(result.c_str()+at+1,"%lf MB/s end to end incl. network, %lf MB/s flash",&e2e,&flash);
+    bool ok;
+    if (u.expect==NULL) {
+      ok=(code==200 && result.rfind("OK",0)==0 && Update.hostCommitted() && Update.hostWritten()==image.size() && memcmp(Update.hostImage(),image.data(),image.size())==0);
+    } else {
+      ok=(result.find(u.expect)!=std::string::npos && !Update.hostCommitted());
+    }
+    printf("%-28s %-24.24s %10.2f %10.2f %9zu KB%s\n",u.name,result.substr(0,result.find('\n')).c_str(),e2e,flash,(after.peak-before.inUse)/1024,ok ? "" : "  <- wrong");
+    if (!ok) failed++;
+    //the web server's response strings come and go, anything the update path kept would be KBs
+    if (after.inUse>before.inUse+1024) {
+      printf("  %zu bytes still allocated after the upload\n",after.inUse-before.inUse);
+      failed++;
+    }
+    hostRestarted=false;
+  }
+  tinflHostLookahead=0;
+  hostExit(failed>0 ? 1 : 0);
+}
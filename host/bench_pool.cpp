@@ -0,0 +1,70 @@
+/*
+ * Invoice Pool Simulation (host)
+ */
+
+//back-to-back sales against the fake LNbits at different LNbits response times, to show what the
+//invoice pool buys: as long as the pool task keeps up, payment->next QR is only the two panel
+//refreshes (dorian, then the QR code), whatever LNbits takes. once customers pay faster than LNbits
+//issues invoices the pool runs dry and the wait for LNbits shows up again. each phase starts with a
+//full pool, "ready" is how many invoices besides the one on screen were waiting when a sale came in
+//
+//  bench_pool [sales per phase=12]
+
+#include "lnCandyESP32.ino.cpp"
+#include "harness.h"
+
+struct Phase {
+  uint32_t lnbitsMs, thinkMs;
+};
+
+//invoices in the pool other than the one on screen
+static uint8_t poolReady() {
+  return invoicePoolSize-poolFree()-1;
+}
+
+int main(int argc, char **argv) {
+  uint32_t sales=(argc>1) ? atoi(argv[1]) : 12;
+  const Phase phases[]={{150,0},{150,400},{1000,0},{1000,2000},{3000,0}};
+  harnessBoot();
+
+  HarnessQR qr;
+  if (!harnessWaitQR(0,qr,30000)) {
+    printf("FAIL: no QR code 30 s after boot\n");
+    hostExit(1);
+  }
+  printf("%u sales per phase, pool of %u\n",sales,invoicePoolSize);
+  uint32_t failed=0;
+  for (const Phase &phase : phases) {
+    fakeLnbitsLatencyMs=phase.lnbitsMs;
+    for (uint16_t i=0; i<3000 && poolFree()>0; i++) hostSleepUs(10000); //start full
+    std::vector<int64_t> toQR;
+    uint8_t minReady=invoicePoolSize;
+    for (uint32_t i=0; i<sales; i++) {
+      hostSleepUs((int64_t)phase.thinkMs*1000);
+      uint8_t ready=poolReady();
+      if (ready<minReady) minReady=ready;
+      int64_t sent;
+      if (fakeLnbitsPay(qr.hash,&sent)!=200) {
+        failed++;
+        continue;
+      }
+      if (!harnessWaitQR(qr.seq,qr,phase.lnbitsMs*4+30000)) {
+        printf("FAIL: no new QR code after a sale\n");
+        hostExit(1);
+      }
+      toQR.push_back(qr.at-sent);
+    }
+    char what[48];
+    snprintf(what,sizeof(what),"LNbits %u ms, think %u ms",phase.lnbitsMs,phase.thinkMs);
+    HostHeapBypass bypass;
+    printf("%-30s payment->next QR p50 %7.1f ms  p99 %7.1f ms  max %7.1f ms  ready at sale min %u\n",what,
+      harnessPercentile(toQR,50)/1000.0,harnessPercentile(toQR,99)/1000.0,harnessPercentile(toQR,100)/1000.0,minReady);
+  }
+  FakeLnbitsStats lnbits=fakeLnbitsStats();
+  printf("LNbits: %u invoices over %u TLS connections\n",lnbits.invoices,lnbits.connections);
+  if (failed>0) {
+    printf("FAIL: %u payments refused\n",failed);
+    hostExit(1);
+  }
+  hostExit(0);
+}
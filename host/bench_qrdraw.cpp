@@ -0,0 +1,145 @@
+/*
+ * QR Drawing Benchmark (host)
+ */
+
+//draws invoices the way the sketch does now and the way it used to, on the mock GxEPD2 frame buffer,
+//and compares draw calls, pixels written, host CPU time for the whole draw and the panel time the
+//refreshes take (GxEPD2's figures for the 1.54" panel, modelled rather than slept, incl. the full
+//refresh every fullRefreshEvery partials). every frame is checked module by module against the QR
+//matrix, so a faster renderer can't get away with drawing the wrong thing
+//
+//  bench_qrdraw [sales=20]
+
+#include "lnCandyESP32.ino.cpp"
+#include "fakelnbits.h"
+#include <chrono>
+
+struct DrawCost {
+  uint32_t drawCalls, full, partial;
+  uint64_t pixelWrites, panelUs;
+  double rasterUs;
+};
+
+static PanelStats before;
+
+static void costStart() { before=panelStats; }
+
+static DrawCost costSince(double rasterUs) {
+  return {panelStats.drawCalls-before.drawCalls,panelStats.fullRefreshes-before.fullRefreshes,panelStats.partialRefreshes-before.partialRefreshes,
+    panelStats.pixelWrites-before.pixelWrites,panelStats.refreshUs-before.refreshUs,rasterUs};
+}
+
+static double usSince(std::chrono::steady_clock::time_point t) {
+  return std::chrono::duration<double,std::micro>(std::chrono::steady_clock::now()-t).count();
+}
+
+//the renderer before packed bitmaps: v11 hard coded, re-encoded on every draw, one fillRect per dark
+//module and a full refresh for the banner and another for the code
+static void drawBaseline(const char *request, QRCode &qrcode, uint8_t *modules) {
+  display.fillScreen(GxEPD_WHITE);
+  displayText("SCAN TOP PAY",0,92,true);
+  qrcode_initText(&qrcode,modules,11,0,request);
+  byte box_x=8, box_y=16, box_s=3, init_x=box_x;
+  for (uint8_t y=0; y<qrcode.size; y++) {
+    for (uint8_t x=0; x<qrcode.size; x++) {
+      if (qrcode_getModule(&qrcode,x,y)) display.fillRect(box_x,box_y,box_s,box_s,GxEPD_BLACK);
+      box_x+=box_s;
+    }
+    box_y+=box_s;
+    box_x=init_x;
+  }
+  display.display(false);
+}
+
+//every module of qrcode is the right color at scale s from (bx,by)
+static bool frameMatches(QRCode &qrcode, uint8_t bx, uint8_t by, uint8_t s) {
+  for (uint8_t y=0; y<qrcode.size; y++) {
+    for (uint8_t x=0; x<qrcode.size; x++) {
+      bool dark=qrcode_getModule(&qrcode,x,y);
+      for (uint8_t dy=0; dy<s; dy++) for (uint8_t dx=0; dx<s; dx++) if (display.pixel(bx+x*s+dx,by+y*s+dy)!=dark) return false;
+    }
+  }
+  return true;
+}
+
+//the QR code currentInvoice should have put on screen, where createInvoiceQR() put it
+static bool currentMatches() {
+  QRCode qrcode;
+  qrcode.version=currentInvoice.qrVersion; qrcode.ecc=currentInvoice.qrEcc; qrcode.size=currentInvoice.qrSize;
+  qrcode.modules=currentInvoice.qrModules;
+  uint8_t s=qrArea/qrcode.size, pixels=qrcode.size*s;
+  return frameMatches(qrcode,(display.width()-pixels)/2,qrAreaY+(qrArea-pixels)/2,s);
+}
+
+static void print(const char *what, const DrawCost &c, uint32_t n) {
+  printf("%-26s %8.1f %12.0f %10.1f %8.2f/%-6.2f %9.1f\n",what,(double)c.drawCalls/n,(double)c.pixelWrites/n,c.rasterUs/n,(double)c.full/n,(double)c.partial/n,c.panelUs/1000.0/n);
+}
+
+static void add(DrawCost &sum, const DrawCost &c) {
+  sum.drawCalls+=c.drawCalls; sum.full+=c.full; sum.partial+=c.partial;
+  sum.pixelWrites+=c.pixelWrites; sum.panelUs+=c.panelUs; sum.rasterUs+=c.rasterUs;
+}
+
+//a new payment request of len chars, encoded into currentInvoice as the invoice task does
+static void nextInvoice(uint16_t len) {
+  uint8_t hash[32];
+  for (uint8_t j=0; j<32; j++) hash[j]=esp_random();
+  fakeLnbitsBolt11(currentInvoice.request,sizeof(currentInvoice.request),len,25,hash);
+  for (char *c=currentInvoice.request; *c; c++) *c=toupper(*c);
+  encodeInvoiceQR(currentInvoice);
+  invoiceShown=true;
+}
+
+int main(int argc, char **argv) {
+  uint32_t sales=(argc>1) ? atoi(argv[1]) : 20;
+  hostDeviceThread();
+  panelModelTiming=false;
+  display.init(115200);
+  display.setRotation(1);
+  display.setFont(&FreeMonoBold9pt7b);
+  display.setTextColor(GxEPD_BLACK);
+  layoutBanners();
+
+  static uint8_t baselineModules[qrBufferMax];
+  DrawCost baseline={}, afterSale={}, redraw={};
+  uint32_t wrong=0;
+  for (uint32_t i=0; i<sales; i++) {
+    nextInvoice(300);
+    QRCode old;
+    costStart();
+    auto t=std::chrono::steady_clock::now();
+    drawBaseline(currentInvoice.request,old,baselineModules);
+    add(baseline,costSince(usSince(t)));
+    if (!frameMatches(old,8,16,3)) wrong++;
+  }
+
+  partialRefreshes=0;
+  for (uint32_t i=0; i<sales; i++) {
+    nextInvoice(300);
+    //a sale: dorian goes up, then the next QR code (loop() does this for every sale)
+    showDorian(false);
+    costStart();
+    auto t=std::chrono::steady_clock::now();
+    createInvoiceQR();
+    add(afterSale,costSince(usSince(t)));
+    if (!currentMatches()) wrong++;
+
+    //an older invoice was paid: the banner is still up, only the code is redrawn
+    costStart();
+    t=std::chrono::steady_clock::now();
+    createInvoiceQR();
+    add(redraw,costSince(usSince(t)));
+    if (!currentMatches()) wrong++;
+  }
+
+  printf("%u invoices of 300 chars (QR v%u, ecc %u, %ux%u), per draw:\n",sales,currentInvoice.qrVersion,currentInvoice.qrEcc,currentInvoice.qrSize,currentInvoice.qrSize);
+  printf("%-26s %8s %12s %10s %15s %9s\n","","draws","pixels","host us","full/partial","panel ms");
+  print("baseline (fillRect, v11)",baseline,sales);
+  print("QR after a sale",afterSale,sales);
+  print("QR redraw, banner kept",redraw,sales);
+  if (wrong>0) {
+    printf("FAIL: %u frames don't match the QR matrix\n",wrong);
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,103 @@
+/*
+ * BOLT11 QR Encode Suite (host)
+ */
+
+//runs the payment requests in host/fixtures/bolt11.txt (plain LNbits invoices, description hashes,
+//big amounts, route hints, long descriptions, and some too long for the panel) through
+//encodeInvoiceQR() as the invoice task does and checks the choice: the smallest version that holds
+//the request, the highest ECC that still fits it, at least 2px per module inside the QR area, and a
+//clean refusal for what doesn't fit. reports version, ECC, encode time, the matrix bytes the invoice
+//caches and the time a redraw takes to turn the cached matrix into a bitmap. encode time is the host
+//QR encoder's, which does the same work as the library on the ESP32 (Reed-Solomon, all 8 masks scored)
+//
+//  bench_qrencode [iterations=200]
+
+#include "lnCandyESP32.ino.cpp"
+#include <chrono>
+#include <fstream>
+#include <sstream>
+
+#ifndef HOST_FIXTURES
+#define HOST_FIXTURES "host/fixtures"
+#endif
+
+static const char *eccName[]={"L","M","Q","H"};
+
+//is the version/ecc encodeInvoiceQR() picked for len the one it should have
+static bool bestChoice(uint16_t len, uint8_t version, uint8_t ecc) {
+  if (len>qrAlnumCapacity[version-1][ecc]) return false;
+  if (version>1 && len<=qrAlnumCapacity[version-2][ECC_LOW]) return false;
+  if (ecc<ECC_HIGH && len<=qrAlnumCapacity[version-1][ecc+1]) return false;
+  return true;
+}
+
+int main(int argc, char **argv) {
+  uint32_t iterations=(argc>1) ? atoi(argv[1]) : 200;
+  std::ifstream fixtures(HOST_FIXTURES "/bolt11.txt");
+  if (!fixtures) {
+    printf("FAIL: no bolt11.txt\n");
+    return 1;
+  }
+  hostDeviceThread();
+  panelModelTiming=false;
+  display.init(115200);
+  display.setRotation(1);
+  display.setFont(&FreeMonoBold9pt7b);
+  layoutBanners();
+
+  printf("sizeof(Invoice) %zu, QR matrix cache %u bytes of it\n",sizeof(Invoice),qrBufferMax);
+  printf("%-22s %5s %4s %4s %6s %5s %10s %8s %10s %7s  %s\n","request","chars","ver","ecc","size","px","encode us","matrix","bitmap us","allocs","result");
+  uint32_t wrong=0;
+  std::string line;
+  while (std::getline(fixtures,line)) {
+    std::string name, request;
+    {
+      HostHeapBypass bypass;
+      if (line.empty() || line[0]=='#') continue;
+      std::istringstream fields(line);
+      fields>>name>>request;
+    }
+    uint16_t len=request.size();
+    bool fits=(len<paymentRequestMax && len<=qrAlnumCapacity[qrMaxVersion-1][ECC_LOW]);
+    if (len>=paymentRequestMax) {
+      //jsonString() refuses it before it gets this far, the invoice is discarded
+      printf("%-22s %5u %4s %4s %6s %5s %10s %8s %10s %7s  %s\n",name.c_str(),len,"-","-","-","-","-","-","-","-","too long for the invoice buffer");
+      continue;
+    }
+    Invoice &inv=currentInvoice;
+    memcpy(inv.request,request.c_str(),len+1);
+    for (char *c=inv.request; *c; c++) *c=toupper(*c);
+
+    hostHeapResetCounts();
+    bool ok=false;
+    auto t=std::chrono::steady_clock::now();
+    for (uint32_t i=0; i<iterations; i++) ok=encodeInvoiceQR(inv);
+    double encodeUs=std::chrono::duration<double,std::micro>(std::chrono::steady_clock::now()-t).count()/iterations;
+    uint64_t allocs=hostHeapStats().allocs;
+
+    if (!ok) {
+      bool right=!fits;
+      if (!right) wrong++;
+      printf("%-22s %5u %4s %4s %6s %5s %10.1f %8s %10s %7.2f  %s\n",name.c_str(),len,"-","-","-","-",encodeUs,"-","-",(double)allocs/iterations,right ? "refused, too long for the panel" : "WRONG, refused");
+      continue;
+    }
+    uint8_t scale=qrArea/inv.qrSize;
+    bool right=fits && bestChoice(len,inv.qrVersion,inv.qrEcc) && scale>=2 && inv.qrSize*scale<=qrArea;
+    if (!right) wrong++;
+
+    //a redraw only rasterizes the cached matrix, createInvoiceQR() times that into qrRenderHist
+    uint32_t count=qrRenderHist.count;
+    uint64_t sum=qrRenderHist.sum;
+    invoiceShown=true;
+    for (uint32_t i=0; i<10; i++) createInvoiceQR();
+    double bitmapUs=(double)(qrRenderHist.sum-sum)/(qrRenderHist.count-count);
+
+    printf("%-22s %5u %4u %4s %3ux%-3u %4u %10.1f %8u %10.1f %7.2f  %s\n",name.c_str(),len,inv.qrVersion,eccName[inv.qrEcc],inv.qrSize,inv.qrSize,scale,encodeUs,
+      qrcode_getBufferSize(inv.qrVersion),bitmapUs,(double)allocs/iterations,right ? "ok" : "WRONG");
+  }
+  if (wrong>0) {
+    printf("FAIL: %u requests got the wrong QR code\n",wrong);
+    return 1;
+  }
+  return 0;
+}
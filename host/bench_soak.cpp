@@ -0,0 +1,96 @@
+/*
+ * Heap Soak Test (host)
+ */
+
+//a long run of back-to-back sales against the fake LNbits with time compressed (hostTimeScale), to
+//check that the sale path doesn't leak or fragment the heap. every tenth of the run it prints the
+//device allocations per sale since the last line, heap in use, the peak, and the largest free block.
+//the only allocations left per sale should be WiFiServer::available()'s client for the webhook
+//(socket handle, receive buffer object and its buffer), freed again when the client is stopped.
+//at the end GET /journal has to list the newest sales in order, up to the last one sold
+//
+//  bench_soak [sales=100000]
+
+#include "lnCandyESP32.ino.cpp"
+#include "harness.h"
+#include <sstream>
+
+int main(int argc, char **argv) {
+  uint32_t sales=(argc>1) ? atoi(argv[1]) : 100000;
+  hostTimeScale=0.001;
+  fakeLnbitsIdleMs=5000000; //5 s real time, keep the connection alive between requests like at 1x
+  harnessBoot();
+
+  HarnessQR qr;
+  if (!harnessWaitQR(0,qr,30000)) {
+    printf("FAIL: no QR code 30 s after boot\n");
+    hostExit(1);
+  }
+  //warm up: the first sales allocate what stays allocated (TLS record buffers, OTA/web server state)
+  for (uint32_t i=0; i<20; i++) {
+    fakeLnbitsPay(qr.hash);
+    harnessWaitQR(qr.seq,qr,10000);
+  }
+  for (uint16_t i=0; i<3000 && poolFree()>0; i++) hostSleepUs(1000);
+  hostHeapResetCounts();
+  HostHeapStats first=hostHeapStats(), last=first;
+  uint32_t connects=lnbitsConnectsTotal;
+
+  printf("%u sales at %gx time\n",sales,1/hostTimeScale);
+  printf("%10s %12s %10s %10s %14s %8s\n","sales","allocs/sale","in use","peak","largest free","failed");
+  printf("%10u %12s %10zu %10zu %14zu %8llu\n",0,"-",first.inUse,first.peak,first.largestFree,(unsigned long long)first.failed);
+  uint32_t step=(sales>=10) ? sales/10 : 1;
+  for (uint32_t i=1; i<=sales; i++) {
+    if (fakeLnbitsPay(qr.hash)!=200) {
+      printf("FAIL: sale %u not accepted\n",i);
+      hostExit(1);
+    }
+    if (!harnessWaitQR(qr.seq,qr,30000)) {
+      printf("FAIL: no new QR code after sale %u\n",i);
+      hostExit(1);
+    }
+    if (i%step==0 || i==sales) {
+      HostHeapStats now=hostHeapStats();
+      printf("%10u %12.2f %10zu %10zu %14zu %8llu\n",i,(double)(now.allocs-last.allocs)/(i%step==0 ? step : i%step),now.inUse,now.peak,now.largestFree,(unsigned long long)now.failed);
+      last=now;
+    }
+  }
+  for (uint16_t i=0; i<3000 && poolFree()>0; i++) hostSleepUs(1000);
+  HostHeapStats end=hostHeapStats();
+  printf("%.2f allocations per sale, %u new LNbits connections, in use %+lld bytes, largest free block %+lld bytes\n",(double)end.allocs/sales,
+    lnbitsConnectsTotal-connects,(long long)end.inUse-(long long)first.inUse,(long long)end.largestFree-(long long)first.largestFree);
+
+  uint32_t failed=0;
+  if (end.failed>0) {
+    printf("FAIL: %llu allocations failed\n",(unsigned long long)end.failed);
+    failed++;
+  }
+  if (end.inUse>first.inUse+1024) {
+    printf("FAIL: heap in use grew by %zu bytes\n",end.inUse-first.inUse);
+    failed++;
+  }
+  if (end.largestFree+1024<first.largestFree) {
+    printf("FAIL: largest free block shrank by %zu bytes\n",first.largestFree-end.largestFree);
+    failed++;
+  }
+
+  //the journal, as it would be pulled for reconciliation
+  HostResponse journal=ota.hostGet("/journal");
+  HostHeapBypass bypass;
+  std::istringstream lines(journal.body);
+  std::string line;
+  uint32_t listed=0, prev=0;
+  bool ordered=std::getline(lines,line) && line=="seq,epoch,payment_hash,amount";
+  while (std::getline(lines,line)) {
+    uint32_t seq=strtoul(line.c_str(),NULL,10);
+    if (listed>0 && seq!=prev+1) ordered=false;
+    prev=seq;
+    listed++;
+  }
+  printf("GET /journal: %d, %u sales listed, the last #%u\n",journal.code,listed,prev);
+  if (journal.code!=200 || !ordered || prev!=unitsSold || listed<std::min<uint32_t>(unitsSold,960)) {
+    printf("FAIL: journal should list the newest sales in order up to #%u\n",unitsSold);
+    failed++;
+  }
+  hostExit(failed>0 ? 1 : 0);
+}
@@ -0,0 +1,87 @@
+/*
+ * LNbits TLS Connection Benchmark (host)
+ */
+
+//invoice requests through the sketch's requestInvoice() against the fake LNbits, three ways: a cold
+//TLS handshake for every request (what HTTPClient did), the same with the previous session offered
+//for resumption (abbreviated handshake, no certificate or key exchange), and the sketch's keep-alive
+//connection, also with the reply sent Transfer-Encoding: chunked as a proxy in front of LNbits may
+//do. every invoice has to parse to one the fake issued. reports request time, handshakes and resumptions as both ends saw them and the heap
+//allocations per request. the fake answers instantly, so what's left is the TLS and HTTP cost - on
+//the machine each handshake also costs WiFi round trips (two for a full one, one resumed) and the
+//ECDHE math, which loopback doesn't show
+//
+//  bench_tls [requests=200]
+
+#include "lnCandyESP32.ino.cpp"
+#include "fakelnbits.h"
+#include <algorithm>
+
+struct Mode {
+  const char *name;
+  bool reconnect, resume, chunked;
+};
+
+int main(int argc, char **argv) {
+  uint32_t requests=(argc>1) ? atoi(argv[1]) : 200;
+  const Mode modes[]={{"cold handshake",true,false,false},{"resumed session",true,true,false},{"keep-alive",false,false,false},
+    {"chunked reply",false,false,true}};
+  fakeLnbitsLatencyMs=0;
+  fakeLnbitsIdleMs=60000;
+  fakeLnbitsStart();
+  hostDeviceThread(); //requests run here the way they do on the invoice task
+  lnbitsTLS.setInsecure();
+  if (!buildInvoiceRequest()) {
+    printf("FAIL: invoice request doesn't fit its buffers\n");
+    hostExit(1);
+  }
+
+  printf("%u invoice requests per mode\n",requests);
+  printf("%-16s %10s %10s %10s %11s %8s %14s %11s\n","mode","p50 us","p99 us","max us","handshakes","resumed","us/handshake","allocs/req");
+  uint32_t failed=0;
+  for (const Mode &mode : modes) {
+    lnbitsTLS.stop();
+    WiFiClientSecure::hostSessionResume=mode.resume;
+    fakeLnbitsChunked=mode.chunked;
+    FakeLnbitsStats before=fakeLnbitsStats();
+    uint32_t handshakes=WiFiClientSecure::hostHandshakes, resumed=WiFiClientSecure::hostResumed;
+    int64_t handshakeUs=WiFiClientSecure::hostHandshakeUs;
+    hostHeapResetCounts();
+    std::vector<int64_t> times;
+    for (uint32_t i=0; i<requests; i++) {
+      if (mode.reconnect) lnbitsTLS.stop();
+      static Invoice inv;
+      int64_t start=hostNow();
+      int status=requestInvoice(inv);
+      int64_t took=hostNow()-start;
+      HostHeapBypass bypass;
+      times.push_back(took);
+      if (status!=201 || fakeLnbitsRequest(inv.hash)==NULL) {
+        printf("FAIL: %s: request %u answered %d, hash %s\n",mode.name,i,status,inv.hash);
+        hostExit(1);
+      }
+    }
+    HostHeapStats heap=hostHeapStats();
+    FakeLnbitsStats after=fakeLnbitsStats();
+    handshakes=WiFiClientSecure::hostHandshakes-handshakes;
+    resumed=WiFiClientSecure::hostResumed-resumed;
+    handshakeUs=WiFiClientSecure::hostHandshakeUs-handshakeUs;
+    HostHeapBypass bypass;
+    std::sort(times.begin(),times.end());
+    printf("%-16s %10lld %10lld %10lld %11u %8u %14lld %11.1f\n",mode.name,(long long)times[times.size()/2],(long long)times[times.size()*99/100],(long long)times.back(),
+      handshakes,resumed,(long long)(handshakeUs/handshakes),(double)heap.allocs/requests);
+
+    //both ends have to agree on what happened
+    uint32_t wantHandshakes=mode.reconnect ? requests : 1;
+    uint32_t wantResumed=mode.resume ? requests-1 : 0;
+    if (handshakes!=wantHandshakes || after.handshakes-before.handshakes!=wantHandshakes) {
+      printf("  expected %u handshakes, client saw %u, server %u\n",wantHandshakes,handshakes,after.handshakes-before.handshakes);
+      failed++;
+    }
+    if (resumed!=wantResumed || after.resumed-before.resumed!=wantResumed) {
+      printf("  expected %u resumed, client saw %u, server %u\n",wantResumed,resumed,after.resumed-before.resumed);
+      failed++;
+    }
+  }
+  hostExit(failed>0 ? 1 : 0);
+}
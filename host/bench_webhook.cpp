@@ -0,0 +1,87 @@
+/*
+ * Webhook Parse Benchmark (host)
+ */
+
+//replays the LNbits payment webhooks in host/fixtures/webhooks through the parser exactly as
+//handleWebhook() feeds it (128 byte reads, then jsonString() for payment_hash) and reports time and
+//heap allocations per request. the index lists what each one has to parse to, rejects included. the
+//1 byte column feeds a byte at a time, the worst a slow connection can do, and should cost about
+//the same per byte
+//
+//  bench_webhook [iterations=20000]
+
+#include <Arduino.h>
+#include "httpparser.h"
+#include <chrono>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#ifndef HOST_FIXTURES
+#define HOST_FIXTURES "host/fixtures"
+#endif
+
+HttpParser webhook;
+
+//one request through the parser the way handleWebhook() does it, true if a payment_hash came out
+static bool parse(const std::string &req, size_t chunk, char *hash, size_t hashSize) {
+  httpReset(webhook,"POST ");
+  for (size_t at=0; at<req.size(); at+=chunk) {
+    size_t n=(req.size()-at<chunk) ? req.size()-at : chunk;
+    if (httpFeed(webhook,(const uint8_t*)req.data()+at,n)>=HTTP_DONE) break;
+  }
+  return webhook.state==HTTP_DONE && jsonString(webhook,"payment_hash",hash,hashSize);
+}
+
+static double nsPerRequest(const std::string &req, size_t chunk, uint32_t iterations, uint64_t &allocs) {
+  char hash[paymentHashLen+1];
+  hostHeapResetCounts();
+  auto start=std::chrono::steady_clock::now();
+  for (uint32_t i=0; i<iterations; i++) parse(req,chunk,hash,sizeof(hash));
+  auto end=std::chrono::steady_clock::now();
+  allocs=hostHeapStats().allocs;
+  return std::chrono::duration<double,std::nano>(end-start).count()/iterations;
+}
+
+int main(int argc, char **argv) {
+  uint32_t iterations=(argc>1) ? atoi(argv[1]) : 20000;
+  std::string dir=HOST_FIXTURES "/webhooks/";
+  std::ifstream index(dir+"index.txt");
+  if (!index) {
+    printf("FAIL: no %sindex.txt\n",dir.c_str());
+    return 1;
+  }
+  hostDeviceThread(); //parsing runs on the loop task, its allocations are what's counted
+
+  uint32_t failed=0;
+  printf("%-36s %6s  %10s %10s %8s  %s\n","fixture","bytes","ns/req","ns/req 1B","allocs","result");
+  std::string line;
+  while (std::getline(index,line)) {
+    std::string name, expect, req;
+    {
+      HostHeapBypass bypass; //the harness' own allocations
+      if (line.empty() || line[0]=='#') continue;
+      std::istringstream fields(line);
+      fields>>name>>expect;
+      std::ifstream f(dir+name,std::ios::binary);
+      std::stringstream body;
+      body<<f.rdbuf();
+      req=body.str();
+    }
+
+    char hash[paymentHashLen+1];
+    bool got=parse(req,128,hash,sizeof(hash));
+    bool ok=(expect=="-") ? !got : (got && expect==hash);
+    uint64_t allocs, allocs1;
+    double ns=nsPerRequest(req,128,iterations,allocs);
+    double ns1=nsPerRequest(req,1,iterations/4+1,allocs1);
+    HostHeapBypass bypass;
+    printf("%-36s %6zu  %10.0f %10.0f %8.2f  %s\n",name.c_str(),req.size(),ns,ns1,(double)(allocs+allocs1)/(iterations+iterations/4+1),
+      ok ? (got ? "payment_hash" : "rejected") : "WRONG");
+    if (!ok || allocs+allocs1>0) failed++;
+  }
+  HostHeapBypass bypass;
+  if (failed>0) printf("FAIL: %u fixtures parsed wrong or allocated\n",failed);
+  return failed>0;
+}
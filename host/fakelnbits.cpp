@@ -0,0 +1,338 @@
+/*
+ * Fake LNbits
+ */
+
+#include "fakelnbits.h"
+#include <Arduino.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <openssl/ssl.h>
+#include <openssl/err.h>
+#include <openssl/evp.h>
+#include <openssl/rand.h>
+#include <openssl/x509.h>
+
+volatile FakeLnbitsFault fakeLnbitsFault=FAKE_OK;
+volatile uint32_t fakeLnbitsLatencyMs=150;
+volatile uint32_t fakeLnbitsIdleMs=5000;
+volatile uint16_t fakeLnbitsRequestLen=300;
+volatile bool fakeLnbitsChunked=false;
+
+static SSL_CTX *serverCtx;
+static std::mutex lock;
+static FakeLnbitsStats stats;
+static std::map<std::string,std::string> issued;
+static uint32_t candyCost=25;
+
+FakeLnbitsStats fakeLnbitsStats() {
+  std::lock_guard<std::mutex> g(lock);
+  return stats;
+}
+
+static void count(uint32_t FakeLnbitsStats::*field) {
+  std::lock_guard<std::mutex> g(lock);
+  stats.*field+=1;
+}
+
+//bech32 (BIP 173)
+static const char charset[]="qpzry9x8gf2tvdw0s3jn54khce6mua7l";
+
+static uint32_t polymod(const uint8_t *v, size_t n, uint32_t chk) {
+  static const uint32_t gen[5]={0x3b6a57b2,0x26508e6d,0x1ea119fa,0x3d4233dd,0x2a1462b3};
+  for (size_t i=0; i<n; i++) {
+    uint8_t b=chk>>25;
+    chk=((chk&0x1ffffff)<<5)^v[i];
+    for (uint8_t j=0; j<5; j++) if ((b>>j)&1) chk^=gen[j];
+  }
+  return chk;
+}
+
+//bytes to 5 bit groups, returns how many
+static size_t toFive(const uint8_t *in, size_t n, uint8_t *out) {
+  size_t k=0;
+  uint32_t acc=0;
+  uint8_t bits=0;
+  for (size_t i=0; i<n; i++) {
+    acc=(acc<<8)|in[i];
+    bits+=8;
+    while (bits>=5) {
+      bits-=5;
+      out[k++]=(acc>>bits)&31;
+    }
+  }
+  if (bits>0) out[k++]=(acc<<(5-bits))&31;
+  return k;
+}
+
+//tagged field: type, 10 bit length, data
+static size_t tagged(uint8_t *out, char type, const uint8_t *data, size_t n) {
+  out[0]=strchr(charset,type)-charset;
+  out[1]=n>>5;
+  out[2]=n&31;
+  memcpy(out+3,data,n);
+  return n+3;
+}
+
+void fakeLnbitsBolt11(char *out, size_t size, uint16_t len, uint32_t amount, const uint8_t *hash) {
+  char hrp[24];
+  snprintf(hrp,sizeof(hrp),"lnbc%lun",(unsigned long)amount*10);
+  size_t hrpLen=strlen(hrp);
+  uint8_t data[2048], field[128], bytes[64];
+  size_t n=0;
+  uint32_t now=time(NULL);
+  for (int8_t i=6; i>=0; i--) data[n++]=(now>>(5*i))&31; //timestamp
+  n+=tagged(data+n,'p',field,toFive(hash,32,field));
+  RAND_bytes(bytes,32);
+  n+=tagged(data+n,'s',field,toFive(bytes,32,field)); //payment secret
+  char memo[32];
+  snprintf(memo,sizeof(memo),"For Candy at %u",now);
+  n+=tagged(data+n,'d',field,toFive((const uint8_t*)memo,strlen(memo),field));
+  uint8_t expiry[3]={0x01,0x51,0x80}; //86400 s
+  n+=tagged(data+n,'x',field,toFive(expiry,3,field));
+  uint8_t cltv[1]={18};
+  n+=tagged(data+n,'c',field,toFive(cltv,1,field));
+  uint8_t features[3]={0x02,0x40,0x00};
+  n+=tagged(data+n,'9',field,toFive(features,3,field));
+  //route hints (51 bytes a hop) and then padding in the description hash make up the length asked for
+  long room=(long)len-(long)(hrpLen+1+n+104+6);
+  while (room>=85+3 && n+88+104<sizeof(data)) {
+    RAND_bytes(bytes,51);
+    n+=tagged(data+n,'r',field,toFive(bytes,51,field));
+    room-=85;
+  }
+  if (room>=3) {
+    RAND_bytes(field,room-3);
+    for (long i=0; i<room-3; i++) field[i]&=31;
+    n+=tagged(data+n,'h',field,room-3);
+  }
+  RAND_bytes(bytes,65);
+  n+=toFive(bytes,65,data+n); //signature + recovery id, 104 groups
+
+  uint8_t expand[64];
+  for (size_t i=0; i<hrpLen; i++) expand[i]=hrp[i]>>5;
+  expand[hrpLen]=0;
+  for (size_t i=0; i<hrpLen; i++) expand[hrpLen+1+i]=hrp[i]&31;
+  uint32_t chk=polymod(expand,hrpLen*2+1,1);
+  chk=polymod(data,n,chk);
+  uint8_t zeros[6]={0};
+  chk=polymod(zeros,6,chk)^1;
+  for (uint8_t i=0; i<6; i++) data[n++]=(chk>>(5*(5-i)))&31;
+
+  size_t k=snprintf(out,size,"%s1",hrp);
+  for (size_t i=0; i<n && k+1<size; i++) out[k++]=charset[data[i]];
+  out[(k<size) ? k : size-1]='\0';
+}
+
+static void hex(const uint8_t *b, size_t n, char *out) {
+  for (size_t i=0; i<n; i++) sprintf(out+i*2,"%02x",b[i]);
+}
+
+static bool sendAll(SSL *ssl, const std::string &s) {
+  return SSL_write(ssl,s.data(),s.size())==(int)s.size();
+}
+
+static void reply(SSL *ssl, int code, const char *reason, const std::string &body, bool close) {
+  char head[192];
+  snprintf(head,sizeof(head),"HTTP/1.1 %d %s\r\nContent-Type: application/json\r\nContent-Length: %u\r\nConnection: %s\r\n\r\n",code,reason,(unsigned)body.size(),close ? "close" : "keep-alive");
+  sendAll(ssl,head+body);
+}
+
+//the same, with the body in chunks of odd sizes so chunk-size lines land anywhere in the reader's reads
+static void replyChunked(SSL *ssl, int code, const char *reason, const std::string &body) {
+  char line[32];
+  snprintf(line,sizeof(line),"HTTP/1.1 %d ",code);
+  std::string out=std::string(line)+reason+"\r\nContent-Type: application/json\r\nTransfer-Encoding: chunked\r\nConnection: keep-alive\r\n\r\n";
+  for (size_t at=0, size=1; at<body.size(); at+=size, size=size*3+7) {
+    if (size>body.size()-at) size=body.size()-at;
+    snprintf(line,sizeof(line),(at==0) ? "%zx;ext=1\r\n" : "%zX\r\n",size);
+    out+=line+body.substr(at,size)+"\r\n";
+  }
+  sendAll(ssl,out+"0\r\nX-Trailer: ignored\r\n\r\n");
+}
+
+static void sleepMs(uint32_t ms) {
+  hostSleepUs((int64_t)(ms*1000*hostTimeScale));
+}
+
+//answer one request, false if the connection should be closed
+static bool handle(SSL *ssl, const std::string &req) {
+  count(&FakeLnbitsStats::requests);
+  if (req.compare(0,24,"POST /api/v1/payments HT")!=0 || req.find("\r\nX-Api-Key: ")==std::string::npos) {
+    count(&FakeLnbitsStats::errors);
+    reply(ssl,404,"Not Found","{\"detail\":\"Not Found\"}",true);
+    return false;
+  }
+  sleepMs(fakeLnbitsLatencyMs);
+  switch (fakeLnbitsFault) {
+    case FAKE_5XX:
+      count(&FakeLnbitsStats::errors);
+      reply(ssl,503,"Service Unavailable","{\"detail\":\"upstream unavailable\"}",true);
+      return false;
+    case FAKE_HANG:
+      count(&FakeLnbitsStats::errors);
+      while (fakeLnbitsFault==FAKE_HANG) sleepMs(10);
+      return false;
+    case FAKE_CLOSE:
+      count(&FakeLnbitsStats::errors);
+      return false;
+    default:
+      break;
+  }
+  uint8_t hash[32];
+  RAND_bytes(hash,32);
+  char hashHex[65], request[2048];
+  hex(hash,32,hashHex);
+  fakeLnbitsBolt11(request,sizeof(request),fakeLnbitsRequestLen,candyCost,hash);
+  {
+    std::lock_guard<std::mutex> g(lock);
+    issued[hashHex]=request;
+    stats.invoices++;
+  }
+  std::string body=std::string("{\"payment_hash\":\"")+hashHex+"\",\"payment_request\":\""+request+"\",\"checking_id\":\""+hashHex+"\",\"lnurl_response\":null}";
+  if (fakeLnbitsChunked) replyChunked(ssl,201,"Created",body);
+  else reply(ssl,201,"Created",body,false);
+  return true;
+}
+
+static void serve(int fd) {
+  SSL *ssl=SSL_new(serverCtx);
+  SSL_set_fd(ssl,fd);
+  if (SSL_accept(ssl)!=1) {
+    ERR_clear_error();
+    SSL_free(ssl);
+    close(fd);
+    return;
+  }
+  count(&FakeLnbitsStats::handshakes);
+  if (SSL_session_reused(ssl)) count(&FakeLnbitsStats::resumed);
+  std::string in;
+  char buf[4096];
+  while (true) {
+    size_t end=in.find("\r\n\r\n");
+    if (end!=std::string::npos) {
+      size_t length=0, at=in.find("\r\nContent-Length: ");
+      if (at!=std::string::npos && at<end) length=strtoul(in.c_str()+at+18,NULL,10);
+      if (in.size()>=end+4+length) {
+        std::string req=in.substr(0,end+4+length);
+        in.erase(0,end+4+length);
+        if (!handle(ssl,req)) break;
+        continue;
+      }
+    }
+    if (SSL_pending(ssl)==0) {
+      pollfd p={fd,POLLIN,0};
+      if (poll(&p,1,fakeLnbitsIdleMs*hostTimeScale)<=0) break; //idle, drop it like the proxy would
+    }
+    int n=SSL_read(ssl,buf,sizeof(buf));
+    if (n<=0) break;
+    in.append(buf,n);
+  }
+  ERR_clear_error();
+  SSL_shutdown(ssl); //keeps the session in the cache for resumption
+  ERR_clear_error();
+  SSL_free(ssl);
+  close(fd);
+}
+
+static SSL_CTX *makeContext() {
+  EVP_PKEY *key=EVP_EC_gen("P-256");
+  X509 *cert=X509_new();
+  X509_set_version(cert,2);
+  ASN1_INTEGER_set(X509_get_serialNumber(cert),1);
+  X509_gmtime_adj(X509_getm_notBefore(cert),-3600);
+  X509_gmtime_adj(X509_getm_notAfter(cert),86400);
+  X509_set_pubkey(cert,key);
+  X509_NAME *name=X509_get_subject_name(cert);
+  X509_NAME_add_entry_by_txt(name,"CN",MBSTRING_ASC,(const unsigned char*)"lnbits.com",-1,-1,0);
+  X509_set_issuer_name(cert,name);
+  X509_sign(cert,key,EVP_sha256());
+  SSL_CTX *ctx=SSL_CTX_new(TLS_server_method());
+  SSL_CTX_use_certificate(ctx,cert);
+  SSL_CTX_use_PrivateKey(ctx,key);
+  SSL_CTX_set_session_id_context(ctx,(const unsigned char*)"fakelnbits",10);
+  SSL_CTX_set_options(ctx,SSL_OP_IGNORE_UNEXPECTED_EOF); //a client that just hangs up doesn't void its session
+  X509_free(cert);
+  EVP_PKEY_free(key);
+  return ctx;
+}
+
+uint16_t fakeLnbitsStart() {
+  serverCtx=makeContext();
+  int fd=socket(AF_INET,SOCK_STREAM,0);
+  int one=1;
+  setsockopt(fd,SOL_SOCKET,SO_REUSEADDR,&one,sizeof(one));
+  sockaddr_in addr={};
+  addr.sin_family=AF_INET;
+  addr.sin_addr.s_addr=htonl(INADDR_LOOPBACK);
+  bind(fd,(sockaddr*)&addr,sizeof(addr));
+  listen(fd,16);
+  socklen_t len=sizeof(addr);
+  getsockname(fd,(sockaddr*)&addr,&len);
+  uint16_t port=ntohs(addr.sin_port);
+  std::thread([fd]() {
+    while (true) {
+      int c=accept(fd,NULL,NULL);
+      if (c<0) continue;
+      count(&FakeLnbitsStats::connections);
+      std::thread(serve,c).detach();
+    }
+  }).detach();
+  hostRedirect(443,port);
+  return port;
+}
+
+const char *fakeLnbitsRequest(const char *hash) {
+  std::lock_guard<std::mutex> g(lock);
+  auto it=issued.find(hash);
+  return (it==issued.end()) ? NULL : it->second.c_str();
+}
+
+int fakeLnbitsPay(const char *hash, int64_t *sentAt) {
+  const char *request=fakeLnbitsRequest(hash);
+  std::string bolt11=(request!=NULL) ? request : "";
+  uint8_t preimage[32], wallet[16];
+  RAND_bytes(preimage,32);
+  RAND_bytes(wallet,16);
+  char preimageHex[65], walletHex[33];
+  hex(preimage,32,preimageHex);
+  hex(wallet,16,walletHex);
+  uint32_t now=time(NULL);
+  char body[2048];
+  snprintf(body,sizeof(body),"{\"checking_id\":\"%s\",\"pending\":false,\"amount\":%u,\"fee\":0,\"memo\":\"For Candy at %u\",\"time\":%u,\"bolt11\":\"%s\",\"preimage\":\"%s\",\"payment_hash\":\"%s\",\"expiry\":%u.0,\"extra\":{},\"wallet_id\":\"%s\",\"webhook\":\"http://yourwebhookendpoint:39780\",\"webhook_status\":null}",
+    hash,candyCost*1000,now,now,bolt11.c_str(),preimageHex,hash,now+86400,walletHex);
+  char req[2560];
+  int n=snprintf(req,sizeof(req),"POST / HTTP/1.1\r\nHost: yourwebhookendpoint:39780\r\nUser-Agent: lnbits\r\nContent-Type: application/json\r\nContent-Length: %u\r\n\r\n%s",(unsigned)strlen(body),body);
+
+  uint16_t port=hostListenPort(39780);
+  if (port==0) return -1;
+  int fd=socket(AF_INET,SOCK_STREAM,0);
+  sockaddr_in addr={};
+  addr.sin_family=AF_INET;
+  addr.sin_port=htons(port);
+  addr.sin_addr.s_addr=htonl(INADDR_LOOPBACK);
+  if (sentAt!=NULL) *sentAt=hostNow();
+  if (connect(fd,(sockaddr*)&addr,sizeof(addr))!=0 || send(fd,req,n,MSG_NOSIGNAL)!=n) {
+    close(fd);
+    return -1;
+  }
+  //the status line is all that's needed, LNbits doesn't look at the rest either
+  std::string in;
+  char buf[256];
+  while (in.find("\r\n")==std::string::npos) {
+    pollfd p={fd,POLLIN,0};
+    if (poll(&p,1,10000)<=0) break;
+    ssize_t r=recv(fd,buf,sizeof(buf),0);
+    if (r<=0) break;
+    in.append(buf,r);
+  }
+  close(fd);
+  if (in.compare(0,9,"HTTP/1.1 ")!=0) return -1;
+  return atoi(in.c_str()+9);
+}
@@ -0,0 +1,45 @@
+/*
+ * Fake LNbits
+ */
+
+//a local stand-in for the LNbits API the sketch talks to: TLS on 127.0.0.1 (self-signed, the sketch
+//doesn't check certificates), POST /api/v1/payments issues an invoice with a random payment_hash and
+//a bech32 payment_request of realistic length, and fakeLnbitsPay() delivers the payment webhook to
+//the sketch's webhook listener the way LNbits does. keep-alive connections are dropped after
+//fakeLnbitsIdleMs idle, like LNbits behind its reverse proxy
+
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+
+enum FakeLnbitsFault {
+  FAKE_OK, //201 with an invoice
+  FAKE_5XX, //503 and close
+  FAKE_HANG, //read the request, never answer (until the fault is cleared)
+  FAKE_CLOSE //read the request, close without answering
+};
+
+extern volatile FakeLnbitsFault fakeLnbitsFault;
+extern volatile uint32_t fakeLnbitsLatencyMs; //server time per invoice request
+extern volatile uint32_t fakeLnbitsIdleMs;
+extern volatile uint16_t fakeLnbitsRequestLen; //length of the payment_request it hands out
+extern volatile bool fakeLnbitsChunked; //send invoices Transfer-Encoding: chunked, like some proxies do
+
+struct FakeLnbitsStats {
+  uint32_t connections, handshakes, resumed, requests, invoices, errors;
+};
+FakeLnbitsStats fakeLnbitsStats();
+
+//start listening, also redirects the sketch's port 443 here. returns the port
+uint16_t fakeLnbitsStart();
+
+//the payment_request issued for hash, NULL if it never was
+const char *fakeLnbitsRequest(const char *hash);
+
+//pay an invoice: POST the payment to the sketch's webhook port. returns the http status the sketch
+//answered with (or -1), sentAt is hostNow() just before the request went out
+int fakeLnbitsPay(const char *hash, int64_t *sentAt=NULL);
+
+//a BOLT11-shaped payment request of len chars (at least 240) for amount sats and the 32 byte payment
+//hash: bech32 with a valid checksum, fields laid out as LNbits' invoices are, random signature
+void fakeLnbitsBolt11(char *out, size_t size, uint16_t len, uint32_t amount, const uint8_t *hash);
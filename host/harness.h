@@ -0,0 +1,100 @@
+/*
+ * Sketch Harness (host)
+ */
+
+//runs the sketch the way the ESP32 core does: setup() and then loop() forever on the loop task, here
+//a device thread, against the fake LNbits. every QR code that goes up and every servo start/stop is
+//timestamped through the panel and servo hooks, so benchmarks can watch the machine from the outside
+//the way a customer would. include after the sketch
+
+#pragma once
+#include "fakelnbits.h"
+#include <algorithm>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+struct HarnessQR {
+  char hash[paymentHashLen+1];
+  int64_t at; //hostNow() when the refresh finished
+  uint32_t seq; //QR codes shown so far, incl. this one
+};
+
+static std::mutex harnessLock;
+static std::condition_variable harnessCv;
+static HarnessQR harnessLastQR;
+static std::vector<int64_t> harnessServoStarts, harnessServoStops;
+static std::vector<HarnessQR> harnessQRs;
+
+//loop task: a refresh while an invoice is up whose hash hasn't been on screen before is a new QR code
+static void harnessRefreshed(bool full, int16_t x, int16_t y, int16_t w, int16_t h) {
+  (void)full; (void)x; (void)y; (void)w; (void)h;
+  if (!invoiceShown || strcmp(currentInvoice.hash,harnessLastQR.hash)==0) return;
+  HostHeapBypass bypass;
+  std::lock_guard<std::mutex> g(harnessLock);
+  strcpy(harnessLastQR.hash,currentInvoice.hash);
+  harnessLastQR.at=hostNow();
+  harnessLastQR.seq++;
+  harnessQRs.push_back(harnessLastQR);
+  harnessCv.notify_all();
+}
+
+static void harnessServo(bool running, int64_t at) {
+  HostHeapBypass bypass;
+  std::lock_guard<std::mutex> g(harnessLock);
+  (running ? harnessServoStarts : harnessServoStops).push_back(at);
+  harnessCv.notify_all();
+}
+
+//start the fake LNbits and boot the sketch, returns once its loop is running
+static void harnessBoot() {
+  fakeLnbitsStart();
+  panelOnRefresh=harnessRefreshed;
+  hostServoEvent=harnessServo;
+  std::thread([]() {
+    hostDeviceThread();
+    setup();
+    while (true) loop();
+  }).detach();
+  while (hostListenPort(39780)==0) hostSleepUs(1000);
+}
+
+//wait for a QR code newer than seq, false on timeout (ms, real time)
+static inline bool harnessWaitQR(uint32_t seq, HarnessQR &out, uint32_t timeoutMs) {
+  std::unique_lock<std::mutex> g(harnessLock);
+  if (!harnessCv.wait_for(g,std::chrono::milliseconds(timeoutMs),[&]() { return harnessLastQR.seq>seq; })) return false;
+  out=harnessLastQR;
+  return true;
+}
+
+//wait until the servo has started n times in total, false on timeout
+static inline bool harnessWaitServo(size_t n, uint32_t timeoutMs) {
+  std::unique_lock<std::mutex> g(harnessLock);
+  return harnessCv.wait_for(g,std::chrono::milliseconds(timeoutMs),[&]() { return harnessServoStarts.size()>=n; });
+}
+
+//first QR code that went up after at, false if none has yet
+static inline bool harnessQRAfter(int64_t at, HarnessQR &out) {
+  std::lock_guard<std::mutex> g(harnessLock);
+  for (const HarnessQR &qr : harnessQRs) {
+    if (qr.at>at) {
+      out=qr;
+      return true;
+    }
+  }
+  return false;
+}
+
+//nearest rank percentile (0-100) of the samples, in the samples' unit. same definition as the
+//sketch's latencyPercentile(), so bench_e2e's outside and own figures pick the same sales
+static inline int64_t harnessPercentile(std::vector<int64_t> v, uint8_t pct) {
+  if (v.empty()) return 0;
+  std::sort(v.begin(),v.end());
+  size_t rank=(v.size()*pct+99)/100;
+  return v[(rank>0) ? rank-1 : 0];
+}
+
+static inline void harnessPrintLatency(const char *what, const std::vector<int64_t> &us) {
+  printf("%-20s p50 %7.1f ms  p99 %7.1f ms  max %7.1f ms  (%zu samples)\n",what,harnessPercentile(us,50)/1000.0,harnessPercentile(us,99)/1000.0,harnessPercentile(us,100)/1000.0,us.size());
+}
@@ -0,0 +1,47 @@
+#!/usr/bin/env python3
+"""
+Turn the sketch into a C++ file for the host build.
+
+Does what arduino-builder does before compiling a .ino: includes Arduino.h
+and declares every function the sketch defines ahead of the first function
+definition, so the sketch can call functions defined further down. #line
+directives keep compiler errors pointing into the .ino.
+
+  host/inoproto.py lnCandyESP32.ino build/lnCandyESP32.ino.cpp
+"""
+import re
+import sys
+
+DEF = re.compile(r'^([A-Za-z_][\w:<>,\s\*&]*?[\s\*&])([A-Za-z_]\w*)\s*\(([^;{}]*)\)\s*\{')
+NOT_TYPES = {'if', 'else', 'while', 'for', 'switch', 'return', 'do'}
+
+
+def prototypes(lines):
+    first, protos = None, []
+    for i, line in enumerate(lines):
+        m = DEF.match(line)
+        if not m or m.group(1).split()[0] in NOT_TYPES:
+            continue
+        if first is None:
+            first = i
+        protos.append('%s%s(%s);' % (m.group(1), m.group(2), m.group(3).strip()))
+    return first, protos
+
+
+def main(src, dst):
+    lines = open(src).read().split('\n')
+    first, protos = prototypes(lines)
+    if first is None:
+        first = len(lines)
+    out = ['#include <Arduino.h>', '#line 1 "%s"' % src]
+    out += lines[:first]
+    out += protos
+    out += ['#line %d "%s"' % (first + 1, src)]
+    out += lines[first:]
+    open(dst, 'w').write('\n'.join(out))
+
+
+if __name__ == '__main__':
+    if len(sys.argv) != 3:
+        sys.exit(__doc__.strip())
+    main(sys.argv[1], sys.argv[2])
@@ -0,0 +1,130 @@
+/*
+ * Arduino Core (host)
+ */
+
+//the slice of the ESP32 Arduino core and FreeRTOS the sketch uses, on top of the C++ standard library.
+//tasks are threads, queues/semaphores/notifications behave like their FreeRTOS namesakes (ticks are
+//ms, as configured for the ESP32 core)
+
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdarg.h>
+#include <string.h>
+#include <strings.h>
+#include <ctype.h>
+#include <math.h>
+#include <atomic>
+#include <string>
+#include <type_traits>
+#include "host.h"
+
+typedef uint8_t byte;
+typedef bool boolean;
+#define PROGMEM
+#define pgm_read_byte(p) (*(const uint8_t*)(p))
+
+uint32_t millis();
+uint32_t micros();
+void delay(uint32_t ms);
+void yield();
+uint32_t esp_random();
+
+class String {
+  public:
+    String() {}
+    String(const char *c) : s(c ? c : "") {}
+    String(const std::string &c) : s(c) {}
+    const char *c_str() const { return s.c_str(); }
+    size_t length() const { return s.size(); }
+    bool operator==(const char *o) const { return s==o; }
+  private:
+    std::string s;
+};
+
+struct IPAddress {
+  uint8_t b[4];
+  uint8_t operator[](int i) const { return b[i]; }
+};
+
+class HardwareSerial {
+  public:
+    void begin(uint32_t baud) { (void)baud; }
+    int available();
+    int read();
+    size_t write(uint8_t c) { return write(&c,1); }
+    size_t write(const uint8_t *data, size_t n);
+    size_t printf(const char *fmt, ...) __attribute__((format(printf,2,3)));
+    size_t print(const char *s) { return write((const uint8_t*)s,strlen(s)); }
+    size_t print(const String &s) { return print(s.c_str()); }
+    size_t print(char c) { return write((uint8_t)c); }
+    size_t print(const IPAddress &a) { return printf("%d.%d.%d.%d",a[0],a[1],a[2],a[3]); }
+    template<typename T, typename std::enable_if<std::is_integral<T>::value,int>::type=0>
+    size_t print(T v) { return std::is_signed<T>::value ? printf("%lld",(long long)v) : printf("%llu",(unsigned long long)v); }
+    template<typename T>
+    size_t println(const T &v) { size_t n=print(v); return n+println(); }
+    size_t println() { return print("\r\n"); }
+};
+extern HardwareSerial Serial;
+
+class SPIClass {
+  public:
+    void begin(int8_t sck=-1, int8_t miso=-1, int8_t mosi=-1, int8_t ss=-1) { (void)sck; (void)miso; (void)mosi; (void)ss; }
+    void end() {}
+};
+extern SPIClass SPI;
+
+class EspClass {
+  public:
+    void restart();
+    uint32_t getFreeHeap();
+    uint32_t getMinFreeHeap();
+};
+extern EspClass ESP;
+
+//FreeRTOS
+typedef uint32_t TickType_t;
+typedef int BaseType_t;
+typedef unsigned UBaseType_t;
+#define portMAX_DELAY ((TickType_t)0xFFFFFFFF)
+#define portTICK_PERIOD_MS 1
+#define pdMS_TO_TICKS(ms) ((TickType_t)(ms))
+#define pdTRUE 1
+#define pdFALSE 0
+#define pdPASS pdTRUE
+
+struct HostTask;
+struct HostQueue;
+typedef HostTask *TaskHandle_t;
+typedef HostQueue *QueueHandle_t;
+typedef HostQueue *SemaphoreHandle_t;
+typedef void (*TaskFunction_t)(void *);
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t fn, const char *name, uint32_t stackDepth, void *param, UBaseType_t priority, TaskHandle_t *handle, BaseType_t core);
+TaskHandle_t xTaskGetCurrentTaskHandle();
+void vTaskDelete(TaskHandle_t task);
+UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t task);
+uint32_t ulTaskNotifyTake(BaseType_t clearOnExit, TickType_t wait);
+BaseType_t xTaskNotifyGive(TaskHandle_t task);
+
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t itemSize);
+BaseType_t xQueueSend(QueueHandle_t q, const void *item, TickType_t wait);
+BaseType_t xQueueReceive(QueueHandle_t q, void *item, TickType_t wait);
+BaseType_t xQueuePeek(QueueHandle_t q, void *item, TickType_t wait);
+BaseType_t xQueueReset(QueueHandle_t q);
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t q);
+
+SemaphoreHandle_t xSemaphoreCreateMutex();
+SemaphoreHandle_t xSemaphoreCreateBinary();
+BaseType_t xSemaphoreTake(SemaphoreHandle_t s, TickType_t wait);
+BaseType_t xSemaphoreGive(SemaphoreHandle_t s);
+
+//spinlock critical sections, as portENTER_CRITICAL is across both cores on the ESP32
+struct portMUX_TYPE {
+  std::atomic_flag locked=ATOMIC_FLAG_INIT;
+};
+#define portMUX_INITIALIZER_UNLOCKED {}
+inline void portENTER_CRITICAL(portMUX_TYPE *mux) { while (mux->locked.test_and_set(std::memory_order_acquire)) {} }
+inline void portEXIT_CRITICAL(portMUX_TYPE *mux) { mux->locked.clear(std::memory_order_release); }
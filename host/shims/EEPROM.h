@@ -0,0 +1,18 @@
+/*
+ * EEPROM (host)
+ */
+
+#pragma once
+#include <Arduino.h>
+
+class EEPROMClass {
+  public:
+    EEPROMClass() { memset(data,0xFF,sizeof(data)); }
+    bool begin(size_t size) { (void)size; return true; }
+    template<typename T> T &get(int addr, T &t) { memcpy(&t,data+addr,sizeof(T)); return t; }
+    template<typename T> const T &put(int addr, const T &t) { memcpy(data+addr,&t,sizeof(T)); return t; }
+    bool commit() { return true; }
+  private:
+    uint8_t data[4096];
+};
+extern EEPROMClass EEPROM;
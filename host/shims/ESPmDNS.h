@@ -0,0 +1,11 @@
+/*
+ * ESPmDNS (host)
+ */
+
+#pragma once
+
+class MDNSResponder {
+  public:
+    bool begin(const char *name) { (void)name; return true; }
+};
+extern MDNSResponder MDNS;
@@ -0,0 +1,9 @@
+/*
+ * FreeMonoBold9pt7b (host)
+ */
+
+#pragma once
+#include <GxEPD2_BW.h>
+
+//only the metrics are modelled (see HostPanel::getTextBounds), no glyph bitmaps
+const GFXfont FreeMonoBold9pt7b={11,18};
@@ -0,0 +1,78 @@
+/*
+ * GxEPD2 (host)
+ */
+
+//a 1bpp frame buffer standing in for the panel. drawing calls are counted, refreshes are counted and
+//take as long as GxEPD2's figures for the GDEY0154D67 (full 1200ms, partial 300ms, power on 80ms
+//after hibernate) when panelModelTiming is set, scaled by hostTimeScale. text isn't rasterized, only
+//measured with FreeMonoBold9pt7b's metrics
+
+#pragma once
+#include <Arduino.h>
+
+#define GxEPD_BLACK 0x0000
+#define GxEPD_WHITE 0xFFFF
+
+struct GFXfont {
+  uint8_t xAdvance, yAdvance;
+};
+
+struct PanelStats {
+  uint32_t drawCalls, textCalls; //fill/line/bitmap calls, print calls
+  uint64_t pixelWrites;
+  uint32_t fullRefreshes, partialRefreshes;
+  uint64_t refreshUs; //modelled panel time
+  uint32_t refreshedPixels; //area sent to the panel
+};
+
+extern PanelStats panelStats;
+extern bool panelModelTiming;
+extern void (*panelOnRefresh)(bool full, int16_t x, int16_t y, int16_t w, int16_t h); //called after each refresh
+
+class HostPanel {
+  public:
+    static const uint16_t fullRefreshMs=1200, partialRefreshMs=300, powerOnMs=80;
+
+    void init(uint32_t baud) { (void)baud; }
+    void setRotation(uint8_t r) { (void)r; }
+    void setFont(const GFXfont *f) { font=f; }
+    void setTextColor(uint16_t c) { (void)c; }
+    void setFullWindow() {}
+    int16_t width() const { return 200; }
+    int16_t height() const { return 200; }
+
+    void fillScreen(uint16_t color);
+    void fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color);
+    void drawFastHLine(int16_t x, int16_t y, int16_t w, uint16_t color);
+    void drawPixel(int16_t x, int16_t y, uint16_t color);
+    void drawBitmap(int16_t x, int16_t y, const uint8_t *bitmap, int16_t w, int16_t h, uint16_t color);
+    void drawInvertedBitmap(int16_t x, int16_t y, const uint8_t *bitmap, int16_t w, int16_t h, uint16_t color);
+    void getTextBounds(const char *s, int16_t x, int16_t y, int16_t *x1, int16_t *y1, uint16_t *w, uint16_t *h);
+    void setCursor(int16_t x, int16_t y) { cursorX=x; cursorY=y; }
+    size_t print(const char *s);
+
+    void display(bool partial);
+    void displayWindow(int16_t x, int16_t y, int16_t w, int16_t h);
+    void hibernate() { hibernating=true; }
+
+    bool pixel(int16_t x, int16_t y) const; //true if black in the frame buffer
+  private:
+    uint8_t frame[200*200/8];
+    const GFXfont *font=NULL;
+    int16_t cursorX=0, cursorY=0;
+    bool hibernating=true;
+    void setPixel(int16_t x, int16_t y, bool black);
+    void refresh(bool full, int16_t x, int16_t y, int16_t w, int16_t h);
+};
+
+class GxEPD2_154_D67 {
+  public:
+    static const uint16_t WIDTH=200, HEIGHT=200;
+    GxEPD2_154_D67(int16_t cs, int16_t dc, int16_t rst, int16_t busy) { (void)cs; (void)dc; (void)rst; (void)busy; }
+};
+
+template<typename Driver, uint16_t pageHeight>
+class GxEPD2_BW : public HostPanel {
+  public:
+    GxEPD2_BW(Driver driver) { (void)driver; }
+};
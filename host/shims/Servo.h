@@ -0,0 +1,18 @@
+/*
+ * Servo (host)
+ */
+
+#pragma once
+#include <Arduino.h>
+
+//hostServoEvent is called with the hostNow() time the servo started (running) or stopped turning
+extern void (*hostServoEvent)(bool running, int64_t at);
+
+class Servo {
+  public:
+    uint8_t attach(int pin) { (void)pin; attached=true; return 1; }
+    void write(int value) { (void)value; if (attached && hostServoEvent!=NULL) hostServoEvent(true,hostNow()); }
+    void detach() { if (attached && hostServoEvent!=NULL) hostServoEvent(false,hostNow()); attached=false; }
+  private:
+    bool attached=false;
+};
@@ -0,0 +1,39 @@
+/*
+ * Update (host)
+ */
+
+//writes into a RAM copy of the OTA partition (outside the heap model), allocating the same 4KB sector
+//buffer the ESP32 core does. each full sector costs the modelled erase+program time of ESP32 SPI
+//flash (45ms + 16 pages at 0.7ms) when flashModelTiming is set, scaled by hostTimeScale. end() checks
+//the image starts with the 0xE9 app image magic
+
+#pragma once
+#include <Arduino.h>
+
+#define UPDATE_SIZE_UNKNOWN 0xFFFFFFFF
+
+extern bool flashModelTiming;
+
+class UpdateClass {
+  public:
+    static const size_t partitionSize=0x140000; //app0/app1 in partitions.csv
+    bool begin(size_t size=UPDATE_SIZE_UNKNOWN);
+    size_t write(uint8_t *data, size_t len);
+    bool end(bool evenIfRemaining=false);
+    void abort();
+    bool hasError() { return error!=NULL; }
+    const char *errorString() { return (error!=NULL) ? error : "No Error"; }
+
+    //host only
+    const uint8_t *hostImage() { return image; }
+    size_t hostWritten() { return written; }
+    bool hostCommitted() { return committed; } //end() succeeded, the next boot would run it
+  private:
+    uint8_t *buffer=NULL;
+    size_t bufferLen=0, written=0;
+    bool active=false, committed=false;
+    const char *error=NULL;
+    static uint8_t image[partitionSize];
+    void flushSector();
+};
+extern UpdateClass Update;
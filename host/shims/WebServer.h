@@ -0,0 +1,64 @@
+/*
+ * WebServer (host)
+ */
+
+//routes are registered as on the ESP32 but requests don't come off a socket: the benchmarks call
+//hostGet()/hostUpload(), which run the handlers on the calling thread the way handleClient() would,
+//including the multipart upload callback in HTTP_UPLOAD_BUFLEN chunks
+
+#pragma once
+#include <Arduino.h>
+#include <functional>
+#include <string>
+
+typedef enum { HTTP_ANY, HTTP_GET, HTTP_POST } HTTPMethod;
+typedef enum { UPLOAD_FILE_START, UPLOAD_FILE_WRITE, UPLOAD_FILE_END, UPLOAD_FILE_ABORTED } HTTPUploadStatus;
+
+#define HTTP_UPLOAD_BUFLEN 1436
+#define CONTENT_LENGTH_UNKNOWN ((size_t)-1)
+
+struct HTTPUpload {
+  HTTPUploadStatus status;
+  String filename, name, type;
+  size_t totalSize, currentSize;
+  uint8_t buf[HTTP_UPLOAD_BUFLEN];
+};
+
+struct HostResponse {
+  int code;
+  std::string type, body;
+};
+
+class WebServer {
+  public:
+    typedef std::function<void()> THandlerFunction;
+    WebServer(int port) { (void)port; }
+    void begin() {}
+    void handleClient() {}
+    void on(const char *uri, HTTPMethod method, THandlerFunction fn) { on(uri,method,fn,nullptr); }
+    void on(const char *uri, HTTPMethod method, THandlerFunction fn, THandlerFunction ufn);
+    void send(int code, const char *type, const char *content);
+    void send_P(int code, const char *type, const char *content) { send(code,type,content); }
+    void sendHeader(const char *name, const char *value) { (void)name; (void)value; }
+    void setContentLength(size_t len) { (void)len; }
+    void sendContent(const char *content, size_t len);
+    HTTPUpload &upload() { return currentUpload; }
+    String arg(const char *name);
+
+    //host only. pace (if set) is called before every chunk with the bytes sent so far, to model the
+    //network; abortAt stops the upload there as if the connection dropped
+    HostResponse hostGet(const char *uri);
+    HostResponse hostUpload(const char *uri, const char *filename, const uint8_t *data, size_t len, std::function<void(size_t)> pace=nullptr, size_t abortAt=(size_t)-1);
+  private:
+    struct Route {
+      std::string uri;
+      HTTPMethod method;
+      THandlerFunction fn, ufn;
+    };
+    Route routes[8];
+    uint8_t routeCount=0;
+    std::string query;
+    HostResponse response;
+    HTTPUpload currentUpload;
+    Route *find(const std::string &path, HTTPMethod method);
+};
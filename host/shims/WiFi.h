@@ -0,0 +1,17 @@
+/*
+ * WiFi (host)
+ */
+
+#pragma once
+#include <Arduino.h>
+#include "WiFiClient.h"
+
+typedef enum { WL_IDLE_STATUS=0, WL_CONNECTED=3, WL_DISCONNECTED=6 } wl_status_t;
+
+class WiFiClass {
+  public:
+    void begin(const char *ssid, const char *pass) { (void)ssid; (void)pass; }
+    wl_status_t status() { return WL_CONNECTED; }
+    IPAddress localIP() { return IPAddress{{127,0,0,1}}; }
+};
+extern WiFiClass WiFi;
@@ -0,0 +1,44 @@
+/*
+ * WiFiClient / WiFiServer (host)
+ */
+
+//plain TCP on 127.0.0.1. like the ESP32 core's, every WiFiClient holds a shared socket handle and a
+//shared 1436 byte rx buffer (allocated on first read), so a webhook costs the same allocations here
+
+#pragma once
+#include <Arduino.h>
+#include <memory>
+
+struct HostSocket;
+struct HostRxBuffer;
+
+class WiFiClient {
+  public:
+    WiFiClient() {}
+    explicit WiFiClient(int fd);
+    int connect(const char *host, uint16_t port);
+    size_t write(const uint8_t *data, size_t n);
+    size_t write(uint8_t c) { return write(&c,1); }
+    size_t print(const char *s) { return write((const uint8_t*)s,strlen(s)); }
+    size_t println(const char *s) { return print(s)+println(); }
+    size_t println() { return print("\r\n"); }
+    int available();
+    int read();
+    int read(uint8_t *buf, size_t n);
+    uint8_t connected();
+    void stop();
+    operator bool() { return connected(); }
+  private:
+    std::shared_ptr<HostSocket> socket;
+    std::shared_ptr<HostRxBuffer> rx;
+};
+
+class WiFiServer {
+  public:
+    WiFiServer(uint16_t port) : port(port) {}
+    void begin();
+    WiFiClient available();
+  private:
+    uint16_t port;
+    int fd=-1;
+};
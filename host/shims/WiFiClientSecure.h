@@ -0,0 +1,34 @@
+/*
+ * WiFiClientSecure (host)
+ */
+
+//TLS 1.2 through OpenSSL, the highest the ESP32 core's mbedTLS negotiates. OpenSSL's own allocations
+//are kept out of the heap model, and the blocks mbedTLS holds per connection (16KB in and 4KB out
+//record buffers) plus its transient handshake allocations are allocated in their place
+
+#pragma once
+#include <Arduino.h>
+
+class WiFiClientSecure {
+  public:
+    void setInsecure() {}
+    int connect(const char *host, uint16_t port);
+    size_t write(const uint8_t *data, size_t n);
+    int available();
+    int read(uint8_t *buf, size_t n);
+    uint8_t connected();
+    void stop();
+
+    //host only: offer the previous session when reconnecting (the ESP32 core can't), and counters
+    static bool hostSessionResume;
+    static uint32_t hostHandshakes, hostResumed;
+    static int64_t hostHandshakeUs; //total time spent in handshakes
+  private:
+    int fd=-1;
+    void *ssl=NULL;
+    void *recordBuffers[2]={NULL,NULL};
+    uint8_t rxBuf[2048];
+    size_t rxLen=0, rxPos=0;
+    bool closed=false;
+    bool fill();
+};
@@ -0,0 +1,7 @@
+/*
+ * WiFiUDP (host)
+ */
+
+#pragma once
+
+class WiFiUDP {};
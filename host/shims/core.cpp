@@ -0,0 +1,311 @@
+/*
+ * Arduino Core, FreeRTOS and esp_timer (host)
+ */
+
+#include <Arduino.h>
+#include <esp_timer.h>
+#include <unistd.h>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+double hostTimeScale=1.0;
+bool hostSerialEcho=getenv("LNCANDY_SERIAL")!=NULL && strcmp(getenv("LNCANDY_SERIAL"),"1")==0;
+volatile bool hostRestarted;
+HardwareSerial Serial;
+SPIClass SPI;
+EspClass ESP;
+
+static const std::chrono::steady_clock::time_point hostEpoch=std::chrono::steady_clock::now();
+
+int64_t hostNow() {
+  return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now()-hostEpoch).count();
+}
+
+void hostSleepUs(int64_t us) {
+  if (us>0) std::this_thread::sleep_for(std::chrono::microseconds(us));
+  else std::this_thread::yield();
+}
+
+static int64_t scaled(int64_t us) {
+  return (int64_t)(us*hostTimeScale);
+}
+
+uint32_t millis() { return (uint32_t)(hostNow()/1000); }
+uint32_t micros() { return (uint32_t)hostNow(); }
+void delay(uint32_t ms) { hostSleepUs(scaled((int64_t)ms*1000)); }
+void yield() { std::this_thread::yield(); }
+int64_t esp_timer_get_time() { return hostNow(); }
+
+uint32_t esp_random() {
+  static std::atomic<uint64_t> state{0x9E3779B97F4A7C15ull};
+  uint64_t x=state.fetch_add(0x9E3779B97F4A7C15ull)+0x9E3779B97F4A7C15ull;
+  x=(x^(x>>30))*0xBF58476D1CE4E5B9ull;
+  x=(x^(x>>27))*0x94D049BB133111EBull;
+  return (uint32_t)(x^(x>>31));
+}
+
+void hostExit(int code) {
+  fflush(stdout);
+  fflush(stderr);
+  _exit(code);
+}
+
+//Serial
+static std::mutex serialLock;
+static std::string serialIn;
+
+void hostSerialInput(const char *text) {
+  std::lock_guard<std::mutex> g(serialLock);
+  HostHeapBypass bypass;
+  serialIn+=text;
+}
+
+int HardwareSerial::available() {
+  std::lock_guard<std::mutex> g(serialLock);
+  return serialIn.size();
+}
+
+int HardwareSerial::read() {
+  std::lock_guard<std::mutex> g(serialLock);
+  if (serialIn.empty()) return -1;
+  int c=(uint8_t)serialIn[0];
+  serialIn.erase(0,1);
+  return c;
+}
+
+size_t HardwareSerial::write(const uint8_t *data, size_t n) {
+  if (hostSerialEcho) {
+    HostHeapBypass bypass; //stdio's buffer isn't the sketch's
+    fwrite(data,1,n,stdout);
+  }
+  return n;
+}
+
+size_t HardwareSerial::printf(const char *fmt, ...) {
+  char buf[512];
+  va_list args;
+  va_start(args,fmt);
+  int n=vsnprintf(buf,sizeof(buf),fmt,args);
+  va_end(args);
+  if (n<0) return 0;
+  return write((const uint8_t*)buf,((size_t)n<sizeof(buf)) ? n : sizeof(buf)-1);
+}
+
+void EspClass::restart() { hostRestarted=true; }
+uint32_t EspClass::getFreeHeap() { return hostHeapStats().freeBytes; }
+uint32_t EspClass::getMinFreeHeap() { return hostHeapStats().minFree; }
+
+//tasks. the stack a FreeRTOS task gets comes out of the heap, so the same amount is allocated here
+//(and never touched) to keep the heap model honest
+struct HostTask {
+  const char *name;
+  uint32_t stackDepth;
+  std::mutex lock;
+  std::condition_variable cv;
+  uint32_t notified;
+};
+
+static thread_local HostTask *currentTask;
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t fn, const char *name, uint32_t stackDepth, void *param, UBaseType_t priority, TaskHandle_t *handle, BaseType_t core) {
+  (void)priority; (void)core;
+  HostTask *task=new HostTask();
+  task->name=name;
+  task->stackDepth=stackDepth;
+  task->notified=0;
+  volatile void *stack=malloc(stackDepth);
+  (void)stack;
+  if (handle!=NULL) *handle=task;
+  std::thread([=]() {
+    hostDeviceThread();
+    currentTask=task;
+    fn(param);
+  }).detach();
+  return pdPASS;
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle() {
+  if (currentTask==NULL) {
+    currentTask=new HostTask();
+    currentTask->name="loopTask";
+    currentTask->stackDepth=8192;
+    currentTask->notified=0;
+  }
+  return currentTask;
+}
+
+void vTaskDelete(TaskHandle_t task) {
+  (void)task;
+  for (;;) std::this_thread::sleep_for(std::chrono::hours(1));
+}
+
+//stacks aren't measured on the host, this is what the task was given
+UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t task) {
+  return (task!=NULL) ? task->stackDepth : 0;
+}
+
+template<typename Pred>
+static bool waitFor(std::condition_variable &cv, std::unique_lock<std::mutex> &g, TickType_t wait, Pred pred) {
+  if (wait==portMAX_DELAY) {
+    cv.wait(g,pred);
+    return true;
+  }
+  return cv.wait_for(g,std::chrono::microseconds(scaled((int64_t)wait*1000)),pred);
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t clearOnExit, TickType_t wait) {
+  HostTask *task=xTaskGetCurrentTaskHandle();
+  std::unique_lock<std::mutex> g(task->lock);
+  if (!waitFor(task->cv,g,wait,[&]() { return task->notified>0; })) return 0;
+  uint32_t n=task->notified;
+  task->notified=clearOnExit ? 0 : n-1;
+  return n;
+}
+
+BaseType_t xTaskNotifyGive(TaskHandle_t task) {
+  {
+    std::lock_guard<std::mutex> g(task->lock);
+    task->notified++;
+  }
+  task->cv.notify_all();
+  return pdPASS;
+}
+
+//queues, fixed storage allocated at creation like FreeRTOS. semaphores are queues of 0-byte items
+struct HostQueue {
+  std::mutex lock;
+  std::condition_variable cv;
+  uint8_t *storage;
+  size_t itemSize, length, head, count;
+};
+
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t itemSize) {
+  HostQueue *q=new HostQueue();
+  q->storage=(itemSize>0) ? (uint8_t*)malloc(length*itemSize) : NULL;
+  q->itemSize=itemSize;
+  q->length=length;
+  q->head=0;
+  q->count=0;
+  return q;
+}
+
+BaseType_t xQueueSend(QueueHandle_t q, const void *item, TickType_t wait) {
+  {
+    std::unique_lock<std::mutex> g(q->lock);
+    if (!waitFor(q->cv,g,wait,[&]() { return q->count<q->length; })) return pdFALSE;
+    if (q->itemSize>0) memcpy(q->storage+((q->head+q->count)%q->length)*q->itemSize,item,q->itemSize);
+    q->count++;
+  }
+  q->cv.notify_all();
+  return pdTRUE;
+}
+
+static BaseType_t queueTake(QueueHandle_t q, void *item, TickType_t wait, bool remove) {
+  {
+    std::unique_lock<std::mutex> g(q->lock);
+    if (!waitFor(q->cv,g,wait,[&]() { return q->count>0; })) return pdFALSE;
+    if (q->itemSize>0) memcpy(item,q->storage+q->head*q->itemSize,q->itemSize);
+    if (!remove) return pdTRUE;
+    q->head=(q->head+1)%q->length;
+    q->count--;
+  }
+  q->cv.notify_all();
+  std::this_thread::yield(); //the receiver can be preempted right after it took the item, make that likely
+  return pdTRUE;
+}
+
+BaseType_t xQueueReceive(QueueHandle_t q, void *item, TickType_t wait) { return queueTake(q,item,wait,true); }
+BaseType_t xQueuePeek(QueueHandle_t q, void *item, TickType_t wait) { return queueTake(q,item,wait,false); }
+
+BaseType_t xQueueReset(QueueHandle_t q) {
+  {
+    std::lock_guard<std::mutex> g(q->lock);
+    q->head=0;
+    q->count=0;
+  }
+  q->cv.notify_all();
+  return pdPASS;
+}
+
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t q) {
+  std::lock_guard<std::mutex> g(q->lock);
+  return q->count;
+}
+
+SemaphoreHandle_t xSemaphoreCreateMutex() {
+  SemaphoreHandle_t s=xQueueCreate(1,0);
+  xSemaphoreGive(s);
+  return s;
+}
+
+SemaphoreHandle_t xSemaphoreCreateBinary() { return xQueueCreate(1,0); }
+BaseType_t xSemaphoreTake(SemaphoreHandle_t s, TickType_t wait) { return xQueueReceive(s,NULL,wait); }
+BaseType_t xSemaphoreGive(SemaphoreHandle_t s) { return xQueueSend(s,NULL,0); }
+
+//esp_timer: one service thread runs the callbacks, like the esp_timer task
+struct esp_timer {
+  esp_timer_cb_t callback;
+  void *arg;
+  int64_t deadline; //hostNow(), -1 when not armed
+};
+
+static std::mutex timerLock;
+static std::condition_variable timerCv;
+static esp_timer *timers[16];
+static uint8_t timerCount;
+
+static void timerService() {
+  hostDeviceThread();
+  std::unique_lock<std::mutex> g(timerLock);
+  while (true) {
+    esp_timer *next=NULL;
+    for (uint8_t i=0; i<timerCount; i++) {
+      if (timers[i]->deadline>=0 && (next==NULL || timers[i]->deadline<next->deadline)) next=timers[i];
+    }
+    if (next==NULL) {
+      timerCv.wait(g);
+      continue;
+    }
+    int64_t now=hostNow();
+    if (now<next->deadline) {
+      timerCv.wait_for(g,std::chrono::microseconds(next->deadline-now));
+      continue;
+    }
+    next->deadline=-1;
+    g.unlock();
+    next->callback(next->arg);
+    g.lock();
+  }
+}
+
+esp_err_t esp_timer_create(const esp_timer_create_args_t *args, esp_timer_handle_t *handle) {
+  std::lock_guard<std::mutex> g(timerLock);
+  if (timerCount>=sizeof(timers)/sizeof(timers[0])) return ESP_ERR_NO_MEM;
+  if (timerCount==0) std::thread(timerService).detach();
+  esp_timer *t=new esp_timer();
+  t->callback=args->callback;
+  t->arg=args->arg;
+  t->deadline=-1;
+  timers[timerCount++]=t;
+  *handle=t;
+  return ESP_OK;
+}
+
+esp_err_t esp_timer_start_once(esp_timer_handle_t timer, uint64_t us) {
+  {
+    std::lock_guard<std::mutex> g(timerLock);
+    if (timer->deadline>=0) return ESP_ERR_INVALID_STATE;
+    timer->deadline=hostNow()+scaled(us);
+  }
+  timerCv.notify_all();
+  return ESP_OK;
+}
+
+esp_err_t esp_timer_stop(esp_timer_handle_t timer) {
+  std::lock_guard<std::mutex> g(timerLock);
+  if (timer->deadline<0) return ESP_ERR_INVALID_STATE;
+  timer->deadline=-1;
+  return ESP_OK;
+}
@@ -0,0 +1,175 @@
+/*
+ * EEPROM, Servo, WebServer and Update (host)
+ */
+
+#include <EEPROM.h>
+#include <Servo.h>
+#include <WebServer.h>
+#include <Update.h>
+
+EEPROMClass EEPROM;
+void (*hostServoEvent)(bool running, int64_t at);
+
+//WebServer
+void WebServer::on(const char *uri, HTTPMethod method, THandlerFunction fn, THandlerFunction ufn) {
+  if (routeCount<sizeof(routes)/sizeof(routes[0])) routes[routeCount++]={uri,method,fn,ufn};
+}
+
+void WebServer::send(int code, const char *type, const char *content) {
+  HostHeapBypass bypass; //stands in for the response going out on the socket
+  response={code,type,content};
+}
+
+void WebServer::sendContent(const char *content, size_t len) {
+  HostHeapBypass bypass;
+  response.body.append(content,len);
+}
+
+String WebServer::arg(const char *name) {
+  std::string key=std::string(name)+"=";
+  size_t at=0;
+  while (at<query.size()) {
+    size_t end=query.find('&',at);
+    if (end==std::string::npos) end=query.size();
+    if (query.compare(at,key.size(),key)==0) return String(query.substr(at+key.size(),end-at-key.size()));
+    at=end+1;
+  }
+  return String();
+}
+
+WebServer::Route *WebServer::find(const std::string &path, HTTPMethod method) {
+  for (uint8_t i=0; i<routeCount; i++) {
+    if (routes[i].uri==path && (routes[i].method==HTTP_ANY || routes[i].method==method)) return &routes[i];
+  }
+  return NULL;
+}
+
+HostResponse WebServer::hostGet(const char *uri) {
+  std::string u(uri);
+  size_t q=u.find('?');
+  query=(q==std::string::npos) ? "" : u.substr(q+1);
+  Route *r=find(u.substr(0,q),HTTP_GET);
+  response={404,"text/plain","Not found"};
+  if (r!=NULL) r->fn();
+  return response;
+}
+
+HostResponse WebServer::hostUpload(const char *uri, const char *filename, const uint8_t *data, size_t len, std::function<void(size_t)> pace, size_t abortAt) {
+  std::string u(uri);
+  size_t q=u.find('?');
+  query=(q==std::string::npos) ? "" : u.substr(q+1);
+  Route *r=find(u.substr(0,q),HTTP_POST);
+  response={404,"text/plain","Not found"};
+  if (r==NULL) return response;
+
+  currentUpload.status=UPLOAD_FILE_START;
+  currentUpload.filename=filename;
+  currentUpload.name="update";
+  currentUpload.type="application/octet-stream";
+  currentUpload.totalSize=0;
+  currentUpload.currentSize=0;
+  if (r->ufn) r->ufn();
+  size_t at=0;
+  while (at<len) {
+    if (at>=abortAt) {
+      currentUpload.status=UPLOAD_FILE_ABORTED;
+      if (r->ufn) r->ufn();
+      return {0,"",""}; //connection dropped, no response
+    }
+    if (pace) pace(at);
+    size_t n=(len-at<HTTP_UPLOAD_BUFLEN) ? len-at : HTTP_UPLOAD_BUFLEN;
+    memcpy(currentUpload.buf,data+at,n);
+    currentUpload.status=UPLOAD_FILE_WRITE;
+    currentUpload.currentSize=n;
+    if (r->ufn) r->ufn();
+    currentUpload.totalSize+=n;
+    at+=n;
+  }
+  currentUpload.status=UPLOAD_FILE_END;
+  currentUpload.currentSize=0;
+  if (r->ufn) r->ufn();
+  r->fn();
+  return response;
+}
+
+//Update
+UpdateClass Update;
+uint8_t UpdateClass::image[UpdateClass::partitionSize];
+bool flashModelTiming=true;
+
+static const size_t sectorSize=4096;
+static const uint32_t sectorEraseUs=45000, pageProgramUs=700;
+
+bool UpdateClass::begin(size_t size) {
+  abort();
+  error=NULL;
+  committed=false;
+  if (size!=UPDATE_SIZE_UNKNOWN && size>partitionSize) {
+    error="Not Enough Space";
+    return false;
+  }
+  buffer=(uint8_t*)malloc(sectorSize);
+  if (buffer==NULL) {
+    error="Out of memory";
+    return false;
+  }
+  bufferLen=0;
+  written=0;
+  active=true;
+  return true;
+}
+
+void UpdateClass::flushSector() {
+  if (written+bufferLen>partitionSize) {
+    error="Not Enough Space";
+    return;
+  }
+  memcpy(image+written,buffer,bufferLen);
+  written+=bufferLen;
+  bufferLen=0;
+  if (flashModelTiming) hostSleepUs((int64_t)((sectorEraseUs+16*pageProgramUs)*hostTimeScale));
+}
+
+size_t UpdateClass::write(uint8_t *data, size_t len) {
+  if (!active || error!=NULL) return 0;
+  size_t done=0;
+  while (done<len) {
+    size_t n=sectorSize-bufferLen;
+    if (n>len-done) n=len-done;
+    memcpy(buffer+bufferLen,data+done,n);
+    bufferLen+=n;
+    done+=n;
+    if (bufferLen==sectorSize) {
+      flushSector();
+      if (error!=NULL) return done-n;
+    }
+  }
+  return done;
+}
+
+bool UpdateClass::end(bool evenIfRemaining) {
+  (void)evenIfRemaining;
+  if (!active) {
+    if (error==NULL) error="Not Started";
+    return false;
+  }
+  if (bufferLen>0) flushSector();
+  free(buffer);
+  buffer=NULL;
+  active=false;
+  if (error!=NULL) return false;
+  if (written==0 || image[0]!=0xE9) {
+    error="Magic byte is wrong, not 0xE9";
+    return false;
+  }
+  committed=true;
+  return true;
+}
+
+void UpdateClass::abort() {
+  free(buffer);
+  buffer=NULL;
+  bufferLen=0;
+  if (active) error="Aborted";
+  active=false;
+}
@@ -0,0 +1,45 @@
+/*
+ * esp_partition (host)
+ */
+
+//the journal partition from partitions.csv on a simulated NOR flash: erase sets a 4KB sector to 0xFF,
+//programming can only clear bits, and power can be cut partway through any program or erase. erases,
+//programmed bytes and the time they'd take on ESP32 SPI flash (sector erase 45ms, 0.7ms per 256 byte
+//page touched) are counted in flashStats
+
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include "esp_err.h"
+
+typedef enum { ESP_PARTITION_TYPE_APP=0x00, ESP_PARTITION_TYPE_DATA=0x01 } esp_partition_type_t;
+typedef enum { ESP_PARTITION_SUBTYPE_ANY=0xff } esp_partition_subtype_t;
+
+typedef struct {
+  esp_partition_type_t type;
+  esp_partition_subtype_t subtype;
+  uint32_t address;
+  uint32_t size;
+  char label[17];
+  bool encrypted;
+} esp_partition_t;
+
+const esp_partition_t *esp_partition_find_first(esp_partition_type_t type, esp_partition_subtype_t subtype, const char *label);
+esp_err_t esp_partition_read(const esp_partition_t *part, size_t offset, void *dst, size_t size);
+esp_err_t esp_partition_write(const esp_partition_t *part, size_t offset, const void *src, size_t size);
+esp_err_t esp_partition_erase_range(const esp_partition_t *part, size_t offset, size_t size);
+
+//host only
+struct FlashStats {
+  uint64_t writeCalls, bytesProgrammed, sectorErases;
+  uint64_t busyUs; //modelled flash time
+};
+extern FlashStats flashStats;
+extern bool flashModelTiming; //sleep for the modelled time (scaled by hostTimeScale), shared with Update
+
+struct HostPowerCut {}; //thrown out of the flash call the power failed in
+
+void hostFlashErase(); //whole partition back to 0xFF, stats and wear zeroed, no cut armed
+void hostFlashCutAfter(uint32_t budget); //fail after this many programmed bytes + sector erases
+void hostFlashNoCut();
+uint32_t hostFlashSectorWear(uint16_t sector); //erases of one 4KB sector so far, interrupted ones included
@@ -0,0 +1,114 @@
+/*
+ * esp_partition on simulated NOR flash (host)
+ */
+
+#include <Arduino.h>
+#include <esp_partition.h>
+
+FlashStats flashStats;
+
+static const uint32_t sectorSize=4096, pageSize=256;
+static const uint32_t sectorEraseUs=45000, pageProgramUs=700;
+static const esp_partition_t journalPart={ESP_PARTITION_TYPE_DATA,(esp_partition_subtype_t)0x40,0x3E0000,0x10000,"journal",false};
+
+static uint8_t journalFlash[0x10000];
+static uint32_t journalWear[0x10000/4096];
+static bool flashReady, cutArmed;
+static uint32_t cutBudget;
+static uint32_t tornSeed=12345;
+
+static uint8_t randomByte() {
+  tornSeed=tornSeed*1103515245+12345;
+  return tornSeed>>16;
+}
+
+static void ready() {
+  if (flashReady) return;
+  memset(journalFlash,0xFF,sizeof(journalFlash));
+  flashReady=true;
+}
+
+static void busy(uint64_t us) {
+  flashStats.busyUs+=us;
+  if (flashModelTiming) hostSleepUs((int64_t)(us*hostTimeScale));
+}
+
+//true if the power fails on this byte/erase
+static bool spend() {
+  if (!cutArmed) return false;
+  if (cutBudget==0) {
+    cutArmed=false;
+    return true;
+  }
+  cutBudget--;
+  return false;
+}
+
+const esp_partition_t *esp_partition_find_first(esp_partition_type_t type, esp_partition_subtype_t subtype, const char *label) {
+  if (type!=journalPart.type || (subtype!=ESP_PARTITION_SUBTYPE_ANY && subtype!=journalPart.subtype)) return NULL;
+  if (label!=NULL && strcmp(label,journalPart.label)!=0) return NULL;
+  ready();
+  return &journalPart;
+}
+
+esp_err_t esp_partition_read(const esp_partition_t *part, size_t offset, void *dst, size_t size) {
+  if (offset+size>part->size) return ESP_ERR_INVALID_SIZE;
+  ready();
+  memcpy(dst,journalFlash+offset,size);
+  return ESP_OK;
+}
+
+esp_err_t esp_partition_write(const esp_partition_t *part, size_t offset, const void *src, size_t size) {
+  if (offset+size>part->size) return ESP_ERR_INVALID_SIZE;
+  ready();
+  flashStats.writeCalls++;
+  const uint8_t *s=(const uint8_t*)src;
+  for (size_t i=0; i<size; i++) {
+    if (spend()) {
+      //torn: only some of this byte's bits made it
+      journalFlash[offset+i]&=s[i]|randomByte();
+      throw HostPowerCut();
+    }
+    journalFlash[offset+i]&=s[i];
+    flashStats.bytesProgrammed++;
+  }
+  busy((uint64_t)((offset+size-1)/pageSize-offset/pageSize+1)*pageProgramUs);
+  return ESP_OK;
+}
+
+esp_err_t esp_partition_erase_range(const esp_partition_t *part, size_t offset, size_t size) {
+  if (offset%sectorSize!=0 || size%sectorSize!=0 || offset+size>part->size) return ESP_ERR_INVALID_ARG;
+  ready();
+  for (size_t at=offset; at<offset+size; at+=sectorSize) {
+    if (spend()) {
+      //interrupted erase: some bits of the sector are back to 1, the rest still hold old data
+      for (size_t i=0; i<sectorSize; i++) journalFlash[at+i]|=randomByte()&randomByte();
+      journalWear[at/sectorSize]++;
+      throw HostPowerCut();
+    }
+    memset(journalFlash+at,0xFF,sectorSize);
+    journalWear[at/sectorSize]++;
+    flashStats.sectorErases++;
+    busy(sectorEraseUs);
+  }
+  return ESP_OK;
+}
+
+void hostFlashErase() {
+  memset(journalFlash,0xFF,sizeof(journalFlash));
+  memset(journalWear,0,sizeof(journalWear));
+  memset(&flashStats,0,sizeof(flashStats));
+  flashReady=true;
+  cutArmed=false;
+}
+
+void hostFlashCutAfter(uint32_t budget) {
+  cutBudget=budget;
+  cutArmed=true;
+}
+
+void hostFlashNoCut() { cutArmed=false; }
+
+uint32_t hostFlashSectorWear(uint16_t sector) {
+  return (sector<sizeof(journalWear)/sizeof(journalWear[0])) ? journalWear[sector] : 0;
+}
@@ -0,0 +1,158 @@
+/*
+ * ESP32 Heap Model (host)
+ */
+
+//malloc/free/calloc/realloc are replaced for the whole process. allocations made by device threads
+//(the sketch's tasks and whatever thread runs setup()/loop()) come out of a fixed arena the size of
+//the heap an ESP32 running this sketch has left after WiFi is up, first fit with boundary tags and
+//coalescing on free, so fragmentation shows up the same way. everything else goes to glibc untouched
+
+#include <Arduino.h>
+#include <esp_heap_caps.h>
+#include <atomic>
+
+extern "C" {
+void *__libc_malloc(size_t n);
+void __libc_free(void *p);
+void *__libc_calloc(size_t n, size_t size);
+void *__libc_realloc(void *p, size_t n);
+}
+
+static const size_t arenaSize=200*1024;
+static const size_t headerSize=16, footerSize=8, minBlock=32;
+static const size_t usedBit=1;
+
+alignas(16) static uint8_t arena[arenaSize];
+static bool arenaReady;
+static std::atomic_flag arenaLock=ATOMIC_FLAG_INIT;
+static size_t inUse, peak, lowWater=arenaSize;
+static uint64_t allocCount, freeCount, failedCount;
+
+static __thread bool deviceThread;
+static __thread int bypassDepth;
+
+void hostDeviceThread() { deviceThread=true; }
+bool hostIsDeviceThread() { return deviceThread; }
+HostHeapBypass::HostHeapBypass() { bypassDepth++; }
+HostHeapBypass::~HostHeapBypass() { bypassDepth--; }
+void *hostRawMalloc(size_t n) { return __libc_malloc(n); }
+void hostRawFree(void *p) { __libc_free(p); }
+
+static inline size_t &word(uint8_t *p) { return *(size_t*)p; }
+static inline size_t blockSize(uint8_t *b) { return word(b)&~usedBit; }
+static inline bool blockUsed(uint8_t *b) { return word(b)&usedBit; }
+static inline void setBlock(uint8_t *b, size_t size, bool used) {
+  word(b)=size|(used ? usedBit : 0);
+  word(b+size-footerSize)=size|(used ? usedBit : 0);
+}
+static inline bool inArena(const void *p) { return (const uint8_t*)p>=arena && (const uint8_t*)p<arena+arenaSize; }
+
+static void lock() { while (arenaLock.test_and_set(std::memory_order_acquire)) {} }
+static void unlock() { arenaLock.clear(std::memory_order_release); }
+
+static void *arenaAlloc(size_t n) {
+  size_t need=(n+headerSize+footerSize+15)&~(size_t)15;
+  if (need<minBlock) need=minBlock;
+  lock();
+  if (!arenaReady) {
+    setBlock(arena,arenaSize,false);
+    arenaReady=true;
+  }
+  allocCount++;
+  for (uint8_t *b=arena; b<arena+arenaSize; b+=blockSize(b)) {
+    size_t size=blockSize(b);
+    if (blockUsed(b) || size<need) continue;
+    if (size-need>=minBlock) {
+      setBlock(b+need,size-need,false);
+      size=need;
+    }
+    setBlock(b,size,true);
+    inUse+=size;
+    if (inUse>peak) peak=inUse;
+    if (arenaSize-inUse<lowWater) lowWater=arenaSize-inUse;
+    unlock();
+    return b+headerSize;
+  }
+  failedCount++;
+  unlock();
+  return NULL;
+}
+
+static void arenaFree(void *p) {
+  uint8_t *b=(uint8_t*)p-headerSize;
+  lock();
+  freeCount++;
+  size_t size=blockSize(b);
+  inUse-=size;
+  uint8_t *next=b+size;
+  if (next<arena+arenaSize && !blockUsed(next)) size+=blockSize(next);
+  if (b>arena && !(word(b-footerSize)&usedBit)) {
+    size_t prev=word(b-footerSize);
+    b-=prev;
+    size+=prev;
+  }
+  setBlock(b,size,false);
+  unlock();
+}
+
+static bool accounted() { return deviceThread && bypassDepth==0; }
+
+extern "C" void *malloc(size_t n) {
+  return accounted() ? arenaAlloc(n) : __libc_malloc(n);
+}
+
+extern "C" void free(void *p) {
+  if (p==NULL) return;
+  if (inArena(p)) arenaFree(p);
+  else __libc_free(p);
+}
+
+extern "C" void *calloc(size_t n, size_t size) {
+  if (!accounted()) return __libc_calloc(n,size);
+  if (size!=0 && n>(size_t)-1/size) return NULL;
+  void *p=arenaAlloc(n*size);
+  if (p!=NULL) memset(p,0,n*size);
+  return p;
+}
+
+extern "C" void *realloc(void *p, size_t n) {
+  if (p==NULL) return malloc(n);
+  if (!inArena(p)) return __libc_realloc(p,n);
+  if (n==0) {
+    arenaFree(p);
+    return NULL;
+  }
+  size_t have=blockSize((uint8_t*)p-headerSize)-headerSize-footerSize;
+  if (have>=n) return p;
+  void *q=arenaAlloc(n);
+  if (q==NULL) return NULL;
+  memcpy(q,p,have);
+  arenaFree(p);
+  return q;
+}
+
+HostHeapStats hostHeapStats() {
+  HostHeapStats s;
+  lock();
+  s.allocs=allocCount; s.frees=freeCount; s.failed=failedCount;
+  s.arenaSize=arenaSize; s.inUse=inUse; s.peak=peak;
+  s.freeBytes=arenaSize-inUse; s.minFree=lowWater;
+  s.largestFree=arenaReady ? 0 : arenaSize-headerSize-footerSize;
+  for (uint8_t *b=arena; arenaReady && b<arena+arenaSize; b+=blockSize(b)) {
+    if (!blockUsed(b) && blockSize(b)-headerSize-footerSize>s.largestFree) s.largestFree=blockSize(b)-headerSize-footerSize;
+  }
+  unlock();
+  return s;
+}
+
+void hostHeapResetCounts() {
+  lock();
+  allocCount=0; freeCount=0; failedCount=0;
+  peak=inUse;
+  unlock();
+}
+
+size_t heap_caps_get_largest_free_block(uint32_t caps) {
+  (void)caps;
+  return hostHeapStats().largestFree;
+}
@@ -0,0 +1,55 @@
+/*
+ * Host Build Controls
+ */
+
+//knobs and hooks the host benchmarks use to drive the shims. none of this exists on the ESP32, the
+//sketch itself never touches it
+
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+
+//multiplies delay(), esp_timer one-shots and the modelled panel/flash/servo times, so long runs can be
+//compressed. millis()/micros() always run in real time
+extern double hostTimeScale;
+
+//Serial output is dropped unless this is set (or LNCANDY_SERIAL=1 in the environment)
+extern bool hostSerialEcho;
+void hostSerialInput(const char *text);
+
+//sketch code is "device" code: its heap use is accounted in the ESP32 heap model and its threads
+//count as tasks. tasks created by the shims are marked automatically, the benchmark marks the thread
+//that runs setup()/loop()
+void hostDeviceThread();
+bool hostIsDeviceThread();
+
+//leave without tearing down the sketch's tasks, which never return
+[[noreturn]] void hostExit(int code);
+
+int64_t hostNow(); //us, same clock as esp_timer_get_time()
+void hostSleepUs(int64_t us); //real time, not scaled
+
+extern volatile bool hostRestarted; //ESP.restart() was called
+
+//ESP32 heap model: device allocations come out of a first-fit arena with the ESP32's usable heap
+//size, so free heap, the lowest it got and the largest free block mean the same as on the machine
+struct HostHeapStats {
+  uint64_t allocs, frees, failed; //device allocations since boot (or hostHeapResetCounts())
+  size_t arenaSize, inUse, peak, freeBytes, minFree, largestFree;
+};
+HostHeapStats hostHeapStats();
+void hostHeapResetCounts(); //zero allocs/frees/failed and restart peak from the current use
+void *hostRawMalloc(size_t n); //libc heap, never accounted (shim internals)
+void hostRawFree(void *p);
+
+//while one of these is alive the calling thread's allocations bypass the heap model, used where the
+//host stands in for something that allocates differently on the ESP32 (OpenSSL for mbedTLS)
+struct HostHeapBypass {
+  HostHeapBypass();
+  ~HostHeapBypass();
+};
+
+//network: WiFiServer/WebServer listen on 127.0.0.1 at an ephemeral port, outgoing connections to a
+//device port (443) go to whatever the benchmark redirected it to
+void hostRedirect(uint16_t devicePort, uint16_t hostPort);
+uint16_t hostListenPort(uint16_t devicePort);
@@ -0,0 +1,56 @@
+/*
+ * ROM miniz tinfl (host)
+ */
+
+#include <Arduino.h>
+#include <rom/miniz.h>
+#include <zlib.h>
+
+uint8_t tinflHostLookahead;
+
+static z_stream stream;
+static bool streamReady, streamDone;
+
+static voidpf rawAlloc(voidpf opaque, uInt items, uInt size) { (void)opaque; return hostRawMalloc((size_t)items*size); }
+static void rawFree(voidpf opaque, voidpf p) { (void)opaque; hostRawFree(p); }
+
+void tinfl_init(tinfl_decompressor *r) {
+  r->m_state=0;
+  if (!streamReady) {
+    stream.zalloc=rawAlloc;
+    stream.zfree=rawFree;
+    inflateInit2(&stream,-15);
+    streamReady=true;
+  } else {
+    inflateReset(&stream);
+  }
+  streamDone=false;
+}
+
+tinfl_status tinfl_decompress(tinfl_decompressor *r, const uint8_t *pIn_buf_next, size_t *pIn_buf_size, uint8_t *pOut_buf_start, uint8_t *pOut_buf_next, size_t *pOut_buf_size, uint32_t decomp_flags) {
+  (void)r; (void)pOut_buf_start;
+  if (decomp_flags&TINFL_FLAG_PARSE_ZLIB_HEADER) return TINFL_STATUS_BAD_PARAM; //raw deflate only
+  if (streamDone) {
+    *pIn_buf_size=0;
+    *pOut_buf_size=0;
+    return TINFL_STATUS_DONE;
+  }
+  stream.next_in=(Bytef*)pIn_buf_next;
+  stream.avail_in=*pIn_buf_size;
+  stream.next_out=pOut_buf_next;
+  stream.avail_out=*pOut_buf_size;
+  int err=inflate(&stream,Z_NO_FLUSH);
+  size_t used=*pIn_buf_size-stream.avail_in;
+  *pOut_buf_size-=stream.avail_out;
+  if (err==Z_STREAM_END) {
+    size_t extra=stream.avail_in;
+    used+=(extra<tinflHostLookahead) ? extra : tinflHostLookahead;
+    *pIn_buf_size=used;
+    streamDone=true;
+    return TINFL_STATUS_DONE;
+  }
+  *pIn_buf_size=used;
+  if (err!=Z_OK && err!=Z_BUF_ERROR) return TINFL_STATUS_FAILED;
+  if (stream.avail_out==0) return TINFL_STATUS_HAS_MORE_OUTPUT;
+  return TINFL_STATUS_NEEDS_MORE_INPUT;
+}
@@ -0,0 +1,321 @@
+/*
+ * WiFi, WiFiClient, WiFiServer and WiFiClientSecure (host)
+ */
+
+#include <WiFi.h>
+#include <WiFiClientSecure.h>
+#include <ESPmDNS.h>
+#include <NTPClient.h>
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <signal.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <errno.h>
+#include <mutex>
+#include <openssl/ssl.h>
+#include <openssl/err.h>
+
+WiFiClass WiFi;
+MDNSResponder MDNS;
+int64_t hostEpochOffset;
+
+static struct IgnoreSigpipe {
+  IgnoreSigpipe() { signal(SIGPIPE,SIG_IGN); }
+} ignoreSigpipe;
+
+static std::mutex portLock;
+static uint16_t redirects[8][2], listens[8][2];
+static uint8_t redirectCount, listenCount;
+
+void hostRedirect(uint16_t devicePort, uint16_t hostPort) {
+  std::lock_guard<std::mutex> g(portLock);
+  for (uint8_t i=0; i<redirectCount; i++) {
+    if (redirects[i][0]==devicePort) {
+      redirects[i][1]=hostPort;
+      return;
+    }
+  }
+  if (redirectCount<8) {
+    redirects[redirectCount][0]=devicePort;
+    redirects[redirectCount++][1]=hostPort;
+  }
+}
+
+static uint16_t redirected(uint16_t port) {
+  std::lock_guard<std::mutex> g(portLock);
+  for (uint8_t i=0; i<redirectCount; i++) if (redirects[i][0]==port) return redirects[i][1];
+  return port;
+}
+
+uint16_t hostListenPort(uint16_t devicePort) {
+  std::lock_guard<std::mutex> g(portLock);
+  for (uint8_t i=0; i<listenCount; i++) if (listens[i][0]==devicePort) return listens[i][1];
+  return 0;
+}
+
+static int tcpConnect(uint16_t port) {
+  int fd=socket(AF_INET,SOCK_STREAM,0);
+  if (fd<0) return -1;
+  sockaddr_in addr={};
+  addr.sin_family=AF_INET;
+  addr.sin_port=htons(port);
+  addr.sin_addr.s_addr=htonl(INADDR_LOOPBACK);
+  if (::connect(fd,(sockaddr*)&addr,sizeof(addr))!=0) {
+    close(fd);
+    return -1;
+  }
+  return fd;
+}
+
+//WiFiClient
+struct HostSocket {
+  int fd;
+  HostSocket(int fd) : fd(fd) {}
+  ~HostSocket() { if (fd>=0) close(fd); }
+};
+
+struct HostRxBuffer {
+  static const size_t size=1436;
+  uint8_t *buf=NULL;
+  size_t len=0, pos=0;
+  ~HostRxBuffer() { free(buf); }
+  void fill(int fd) {
+    if (pos<len) return;
+    if (buf==NULL) buf=(uint8_t*)malloc(size);
+    ssize_t n=recv(fd,buf,size,MSG_DONTWAIT);
+    pos=0;
+    len=(n>0) ? n : 0;
+  }
+};
+
+WiFiClient::WiFiClient(int fd) {
+  socket=std::make_shared<HostSocket>(fd);
+  rx=std::make_shared<HostRxBuffer>();
+}
+
+int WiFiClient::connect(const char *host, uint16_t port) {
+  (void)host;
+  int fd=tcpConnect(redirected(port));
+  if (fd<0) return 0;
+  socket=std::make_shared<HostSocket>(fd);
+  rx=std::make_shared<HostRxBuffer>();
+  return 1;
+}
+
+size_t WiFiClient::write(const uint8_t *data, size_t n) {
+  if (!socket || socket->fd<0) return 0;
+  ssize_t sent=send(socket->fd,data,n,MSG_NOSIGNAL);
+  return (sent>0) ? sent : 0;
+}
+
+int WiFiClient::available() {
+  if (!socket || socket->fd<0) return 0;
+  rx->fill(socket->fd);
+  return rx->len-rx->pos;
+}
+
+int WiFiClient::read() {
+  uint8_t c;
+  return (read(&c,1)==1) ? c : -1;
+}
+
+int WiFiClient::read(uint8_t *buf, size_t n) {
+  if (available()<=0) return -1;
+  size_t take=rx->len-rx->pos;
+  if (take>n) take=n;
+  memcpy(buf,rx->buf+rx->pos,take);
+  rx->pos+=take;
+  return take;
+}
+
+uint8_t WiFiClient::connected() {
+  if (!socket || socket->fd<0) return 0;
+  if (rx->pos<rx->len) return 1;
+  uint8_t c;
+  ssize_t n=recv(socket->fd,&c,1,MSG_DONTWAIT|MSG_PEEK);
+  if (n>0) return 1;
+  if (n<0 && (errno==EAGAIN || errno==EWOULDBLOCK)) return 1;
+  return 0;
+}
+
+void WiFiClient::stop() {
+  if (socket && socket->fd>=0) {
+    close(socket->fd);
+    socket->fd=-1;
+  }
+  socket.reset();
+  rx.reset();
+}
+
+//WiFiServer
+void WiFiServer::begin() {
+  fd=::socket(AF_INET,SOCK_STREAM,0);
+  int one=1;
+  setsockopt(fd,SOL_SOCKET,SO_REUSEADDR,&one,sizeof(one));
+  sockaddr_in addr={};
+  addr.sin_family=AF_INET;
+  addr.sin_addr.s_addr=htonl(INADDR_LOOPBACK);
+  bind(fd,(sockaddr*)&addr,sizeof(addr));
+  listen(fd,16);
+  fcntl(fd,F_SETFL,fcntl(fd,F_GETFL)|O_NONBLOCK);
+  socklen_t len=sizeof(addr);
+  getsockname(fd,(sockaddr*)&addr,&len);
+  std::lock_guard<std::mutex> g(portLock);
+  if (listenCount<8) {
+    listens[listenCount][0]=port;
+    listens[listenCount++][1]=ntohs(addr.sin_port);
+  }
+}
+
+WiFiClient WiFiServer::available() {
+  if (fd<0) return WiFiClient();
+  int c=accept(fd,NULL,NULL);
+  if (c<0) return WiFiClient();
+  return WiFiClient(c);
+}
+
+//WiFiClientSecure
+bool WiFiClientSecure::hostSessionResume;
+uint32_t WiFiClientSecure::hostHandshakes, WiFiClientSecure::hostResumed;
+int64_t WiFiClientSecure::hostHandshakeUs;
+
+static SSL_CTX *clientCtx;
+static SSL_SESSION *lastSession;
+static std::mutex tlsLock;
+
+//mbedTLS' footprint on the ESP32: record buffers for the life of the connection, and roughly what the
+//handshake (ECDHE, certificate parsing) allocates and frees again
+static const size_t mbedInBuffer=16384+29, mbedOutBuffer=4096+29, mbedHandshake[]={6144,2048,1536,3072};
+
+int WiFiClientSecure::connect(const char *host, uint16_t port) {
+  (void)host;
+  stop();
+  int64_t start=hostNow();
+  int tcp=tcpConnect(redirected(port));
+  if (tcp<0) return 0;
+
+  void *transient[sizeof(mbedHandshake)/sizeof(mbedHandshake[0])];
+  recordBuffers[0]=malloc(mbedInBuffer);
+  recordBuffers[1]=malloc(mbedOutBuffer);
+  for (size_t i=0; i<sizeof(transient)/sizeof(transient[0]); i++) transient[i]=malloc(mbedHandshake[i]);
+
+  bool ok;
+  {
+    HostHeapBypass bypass;
+    std::lock_guard<std::mutex> g(tlsLock);
+    if (clientCtx==NULL) {
+      clientCtx=SSL_CTX_new(TLS_client_method());
+      SSL_CTX_set_max_proto_version(clientCtx,TLS1_2_VERSION);
+      SSL_CTX_set_verify(clientCtx,SSL_VERIFY_NONE,NULL);
+    }
+    SSL *s=SSL_new(clientCtx);
+    SSL_set_fd(s,tcp);
+    if (hostSessionResume && lastSession!=NULL) SSL_set_session(s,lastSession);
+    ok=(SSL_connect(s)==1);
+    if (ok) {
+      hostHandshakes++;
+      if (SSL_session_reused(s)) hostResumed++;
+      if (hostSessionResume) {
+        if (lastSession!=NULL) SSL_SESSION_free(lastSession);
+        lastSession=SSL_get1_session(s);
+      }
+      ssl=s;
+    } else {
+      SSL_free(s);
+    }
+  }
+  for (size_t i=0; i<sizeof(transient)/sizeof(transient[0]); i++) free(transient[i]);
+  if (!ok) {
+    close(tcp);
+    free(recordBuffers[0]); free(recordBuffers[1]);
+    recordBuffers[0]=recordBuffers[1]=NULL;
+    return 0;
+  }
+  fd=tcp;
+  fcntl(fd,F_SETFL,fcntl(fd,F_GETFL)|O_NONBLOCK);
+  int one=1;
+  setsockopt(fd,IPPROTO_TCP,TCP_NODELAY,&one,sizeof(one));
+  closed=false;
+  rxLen=rxPos=0;
+  hostHandshakeUs+=hostNow()-start;
+  return 1;
+}
+
+bool WiFiClientSecure::fill() {
+  if (ssl==NULL || closed) return false;
+  if (rxPos<rxLen) return true;
+  HostHeapBypass bypass;
+  int n=SSL_read((SSL*)ssl,rxBuf,sizeof(rxBuf));
+  if (n>0) {
+    rxPos=0;
+    rxLen=n;
+    return true;
+  }
+  int err=SSL_get_error((SSL*)ssl,n);
+  if (err!=SSL_ERROR_WANT_READ && err!=SSL_ERROR_WANT_WRITE) closed=true;
+  ERR_clear_error();
+  return false;
+}
+
+size_t WiFiClientSecure::write(const uint8_t *data, size_t n) {
+  if (ssl==NULL || closed) return 0;
+  HostHeapBypass bypass;
+  size_t done=0;
+  while (done<n) {
+    int w=SSL_write((SSL*)ssl,data+done,n-done);
+    if (w>0) {
+      done+=w;
+      continue;
+    }
+    int err=SSL_get_error((SSL*)ssl,w);
+    ERR_clear_error();
+    if (err!=SSL_ERROR_WANT_WRITE && err!=SSL_ERROR_WANT_READ) {
+      closed=true;
+      break;
+    }
+    pollfd p={fd,(short)((err==SSL_ERROR_WANT_WRITE) ? POLLOUT : POLLIN),0};
+    poll(&p,1,100);
+  }
+  return done;
+}
+
+int WiFiClientSecure::available() {
+  fill();
+  return rxLen-rxPos;
+}
+
+int WiFiClientSecure::read(uint8_t *buf, size_t n) {
+  if (!fill()) return -1;
+  size_t take=rxLen-rxPos;
+  if (take>n) take=n;
+  memcpy(buf,rxBuf+rxPos,take);
+  rxPos+=take;
+  return take;
+}
+
+uint8_t WiFiClientSecure::connected() {
+  if (ssl==NULL) return 0;
+  fill();
+  return !closed || rxPos<rxLen;
+}
+
+void WiFiClientSecure::stop() {
+  if (ssl!=NULL) {
+    HostHeapBypass bypass;
+    if (!closed) SSL_shutdown((SSL*)ssl); //close_notify, or OpenSSL won't let the session be resumed
+    ERR_clear_error();
+    SSL_free((SSL*)ssl);
+    ssl=NULL;
+  }
+  if (fd>=0) close(fd);
+  fd=-1;
+  free(recordBuffers[0]); free(recordBuffers[1]);
+  recordBuffers[0]=recordBuffers[1]=NULL;
+  rxLen=rxPos=0;
+  closed=false;
+}
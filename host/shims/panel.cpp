@@ -0,0 +1,101 @@
+/*
+ * GxEPD2 (host)
+ */
+
+#include <GxEPD2_BW.h>
+
+PanelStats panelStats;
+bool panelModelTiming=true;
+void (*panelOnRefresh)(bool full, int16_t x, int16_t y, int16_t w, int16_t h);
+
+void HostPanel::setPixel(int16_t x, int16_t y, bool black) {
+  if (x<0 || y<0 || x>=200 || y>=200) return;
+  uint16_t i=y*200+x;
+  if (black) frame[i>>3]|=0x80>>(i&7);
+  else frame[i>>3]&=~(0x80>>(i&7));
+  panelStats.pixelWrites++;
+}
+
+bool HostPanel::pixel(int16_t x, int16_t y) const {
+  uint16_t i=y*200+x;
+  return frame[i>>3]&(0x80>>(i&7));
+}
+
+void HostPanel::fillScreen(uint16_t color) {
+  memset(frame,(color==GxEPD_BLACK) ? 0xFF : 0x00,sizeof(frame));
+  panelStats.drawCalls++;
+  panelStats.pixelWrites+=200*200;
+}
+
+void HostPanel::fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color) {
+  panelStats.drawCalls++;
+  for (int16_t j=y; j<y+h; j++) for (int16_t i=x; i<x+w; i++) setPixel(i,j,color==GxEPD_BLACK);
+}
+
+void HostPanel::drawFastHLine(int16_t x, int16_t y, int16_t w, uint16_t color) {
+  panelStats.drawCalls++;
+  for (int16_t i=x; i<x+w; i++) setPixel(i,y,color==GxEPD_BLACK);
+}
+
+void HostPanel::drawPixel(int16_t x, int16_t y, uint16_t color) {
+  panelStats.drawCalls++;
+  setPixel(x,y,color==GxEPD_BLACK);
+}
+
+//Adafruit_GFX::drawBitmap: set bits are drawn in color, clear bits are left alone
+void HostPanel::drawBitmap(int16_t x, int16_t y, const uint8_t *bitmap, int16_t w, int16_t h, uint16_t color) {
+  panelStats.drawCalls++;
+  int16_t rowBytes=(w+7)/8;
+  for (int16_t j=0; j<h; j++) {
+    for (int16_t i=0; i<w; i++) {
+      if (bitmap[j*rowBytes+i/8]&(0x80>>(i&7))) setPixel(x+i,y+j,color==GxEPD_BLACK);
+    }
+  }
+}
+
+//GxEPD2's drawInvertedBitmap: clear bits are drawn in color
+void HostPanel::drawInvertedBitmap(int16_t x, int16_t y, const uint8_t *bitmap, int16_t w, int16_t h, uint16_t color) {
+  panelStats.drawCalls++;
+  int16_t rowBytes=(w+7)/8;
+  for (int16_t j=0; j<h; j++) {
+    for (int16_t i=0; i<w; i++) {
+      if (!(bitmap[j*rowBytes+i/8]&(0x80>>(i&7)))) setPixel(x+i,y+j,color==GxEPD_BLACK);
+    }
+  }
+}
+
+//FreeMonoBold9pt7b is monospaced: 11px advance, glyphs reach 12px above and 3px below the baseline
+void HostPanel::getTextBounds(const char *s, int16_t x, int16_t y, int16_t *x1, int16_t *y1, uint16_t *w, uint16_t *h) {
+  size_t n=strlen(s);
+  uint8_t advance=(font!=NULL) ? font->xAdvance : 6;
+  *x1=x+1;
+  *y1=y-12;
+  *w=(n>0) ? n*advance-2 : 0;
+  *h=(n>0) ? 15 : 0;
+}
+
+size_t HostPanel::print(const char *s) {
+  panelStats.textCalls++;
+  size_t n=strlen(s);
+  cursorX+=n*((font!=NULL) ? font->xAdvance : 6);
+  return n;
+}
+
+void HostPanel::refresh(bool full, int16_t x, int16_t y, int16_t w, int16_t h) {
+  uint32_t ms=(full ? fullRefreshMs : partialRefreshMs)+(hibernating ? powerOnMs : 0);
+  hibernating=false;
+  if (full) panelStats.fullRefreshes++;
+  else panelStats.partialRefreshes++;
+  panelStats.refreshUs+=(uint64_t)ms*1000;
+  panelStats.refreshedPixels+=w*h;
+  if (panelModelTiming) delay(ms);
+  if (panelOnRefresh!=NULL) panelOnRefresh(full,x,y,w,h);
+}
+
+void HostPanel::display(bool partial) {
+  refresh(!partial,0,0,200,200);
+}
+
+void HostPanel::displayWindow(int16_t x, int16_t y, int16_t w, int16_t h) {
+  refresh(false,x,y,w,h);
+}
@@ -0,0 +1,347 @@
+/*
+ * QRCode (host)
+ */
+
+#include "qrcode.h"
+#include <stdlib.h>
+#include <string.h>
+
+int8_t qrcodeHostMask=-1;
+
+//error correction codewords per block and number of blocks, [ecc][version] with ecc in ECC_LOW..ECC_HIGH order
+static const uint8_t eccPerBlock[4][41]={
+  {0,7,10,15,20,26,18,20,24,30,18,20,24,26,30,22,24,28,30,28,28,28,28,30,30,26,28,30,30,30,30,30,30,30,30,30,30,30,30,30,30},
+  {0,10,16,26,18,24,16,18,22,22,26,30,22,22,24,24,28,28,26,26,26,26,28,28,28,28,28,28,28,28,28,28,28,28,28,28,28,28,28,28,28},
+  {0,13,22,18,26,18,24,18,22,20,24,28,26,24,20,30,24,28,28,26,30,28,30,30,30,30,28,30,30,30,30,30,30,30,30,30,30,30,30,30,30},
+  {0,17,28,22,16,22,28,26,26,24,28,24,28,22,24,24,30,28,28,26,28,30,24,30,30,30,30,30,30,30,30,30,30,30,30,30,30,30,30,30,30}
+};
+static const uint8_t eccBlocks[4][41]={
+  {0,1,1,1,1,1,2,2,2,2,4,4,4,4,4,6,6,6,6,7,8,8,9,9,10,12,12,12,13,14,15,16,17,18,19,19,20,21,22,24,25},
+  {0,1,1,1,2,2,4,4,4,5,5,5,8,9,9,10,10,11,13,14,16,17,17,18,20,21,23,25,26,28,29,31,33,35,37,38,40,43,45,47,49},
+  {0,1,1,2,2,4,4,6,6,8,8,8,10,12,16,12,17,16,18,21,20,23,23,25,27,29,34,34,35,38,40,43,45,48,51,53,56,59,62,65,68},
+  {0,1,1,2,4,4,4,5,6,8,8,11,11,16,16,18,16,19,21,25,25,25,34,30,32,35,37,40,42,45,48,51,54,57,60,63,66,70,74,77,81}
+};
+static const uint8_t eccFormatBits[4]={1,0,3,2};
+static const char alphanumeric[]="0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZ $%*+-./:";
+
+#define MAX_SIZE 177
+#define GRID_BYTES ((MAX_SIZE*MAX_SIZE+7)/8)
+
+typedef struct {
+  uint8_t *data;
+  uint32_t bits;
+} BitBuffer;
+
+static void bbAppend(BitBuffer *bb, uint32_t value, uint8_t n) {
+  for (int8_t i=n-1; i>=0; i--, bb->bits++) {
+    if ((value>>i)&1) bb->data[bb->bits>>3]|=0x80>>(bb->bits&7);
+  }
+}
+
+static bool gridGet(const uint8_t *grid, uint8_t size, uint8_t x, uint8_t y) {
+  uint32_t at=(uint32_t)y*size+x;
+  return (grid[at>>3]>>(7-(at&7)))&1;
+}
+
+static void gridSet(uint8_t *grid, uint8_t size, uint8_t x, uint8_t y, bool on) {
+  uint32_t at=(uint32_t)y*size+x;
+  if (on) grid[at>>3]|=0x80>>(at&7);
+  else grid[at>>3]&=~(0x80>>(at&7));
+}
+
+uint16_t qrcode_getBufferSize(uint8_t version) {
+  uint16_t size=version*4+17;
+  return ((uint32_t)size*size+7)/8;
+}
+
+bool qrcode_getModule(QRCode *qrcode, uint8_t x, uint8_t y) {
+  if (x>=qrcode->size || y>=qrcode->size) return false;
+  return gridGet(qrcode->modules,qrcode->size,x,y);
+}
+
+static uint32_t rawDataModules(uint8_t version) {
+  uint32_t n=(16*version+128)*version+64;
+  if (version>=2) {
+    uint32_t align=version/7+2;
+    n-=(25*align-10)*align-55;
+    if (version>=7) n-=36;
+  }
+  return n;
+}
+
+//Reed-Solomon over GF(256) with the QR polynomial 0x11D
+static uint8_t gfMul(uint8_t x, uint8_t y) {
+  uint16_t z=0;
+  for (int8_t i=7; i>=0; i--) {
+    z=(z<<1)^((z>>7)*0x11D);
+    z^=((y>>i)&1)*x;
+  }
+  return z;
+}
+
+static void rsRemainder(const uint8_t *data, uint16_t len, uint8_t degree, uint8_t *out) {
+  uint8_t divisor[30];
+  memset(divisor,0,degree);
+  divisor[degree-1]=1;
+  uint8_t root=1;
+  for (uint8_t i=0; i<degree; i++) {
+    for (uint8_t j=0; j<degree; j++) {
+      divisor[j]=gfMul(divisor[j],root);
+      if (j+1<degree) divisor[j]^=divisor[j+1];
+    }
+    root=gfMul(root,2);
+  }
+  memset(out,0,degree);
+  for (uint16_t i=0; i<len; i++) {
+    uint8_t factor=data[i]^out[0];
+    memmove(out,out+1,degree-1);
+    out[degree-1]=0;
+    for (uint8_t j=0; j<degree; j++) out[j]^=gfMul(divisor[j],factor);
+  }
+}
+
+static void setFunction(uint8_t *modules, uint8_t *isFunction, uint8_t size, int16_t x, int16_t y, bool on) {
+  if (x<0 || y<0 || x>=size || y>=size) return;
+  gridSet(modules,size,x,y,on);
+  gridSet(isFunction,size,x,y,true);
+}
+
+static void drawFormat(uint8_t *modules, uint8_t *isFunction, uint8_t size, uint8_t ecc, uint8_t mask) {
+  uint16_t data=(eccFormatBits[ecc]<<3)|mask, rem=data;
+  for (uint8_t i=0; i<10; i++) rem=(rem<<1)^((rem>>9)*0x537);
+  uint16_t bits=((data<<10)|(rem&0x3FF))^0x5412;
+  for (uint8_t i=0; i<=5; i++) setFunction(modules,isFunction,size,8,i,(bits>>i)&1);
+  setFunction(modules,isFunction,size,8,7,(bits>>6)&1);
+  setFunction(modules,isFunction,size,8,8,(bits>>7)&1);
+  setFunction(modules,isFunction,size,7,8,(bits>>8)&1);
+  for (uint8_t i=9; i<15; i++) setFunction(modules,isFunction,size,14-i,8,(bits>>i)&1);
+  for (uint8_t i=0; i<8; i++) setFunction(modules,isFunction,size,size-1-i,8,(bits>>i)&1);
+  for (uint8_t i=8; i<15; i++) setFunction(modules,isFunction,size,8,size-15+i,(bits>>i)&1);
+  setFunction(modules,isFunction,size,8,size-8,true);
+}
+
+static void drawFunctionPatterns(uint8_t *modules, uint8_t *isFunction, uint8_t version, uint8_t size) {
+  for (uint8_t i=0; i<size; i++) {
+    setFunction(modules,isFunction,size,6,i,i%2==0);
+    setFunction(modules,isFunction,size,i,6,i%2==0);
+  }
+  const int16_t finders[3][2]={{3,3},{(int16_t)(size-4),3},{3,(int16_t)(size-4)}};
+  for (uint8_t f=0; f<3; f++) {
+    for (int8_t dy=-4; dy<=4; dy++) {
+      for (int8_t dx=-4; dx<=4; dx++) {
+        int8_t dist=abs(dx)>abs(dy) ? abs(dx) : abs(dy);
+        setFunction(modules,isFunction,size,finders[f][0]+dx,finders[f][1]+dy,dist!=2 && dist!=4);
+      }
+    }
+  }
+  if (version>=2) {
+    uint8_t align=version/7+2, pos[7];
+    uint8_t step=(version==32) ? 26 : (version*4+align*2+1)/(align*2-2)*2;
+    pos[0]=6;
+    for (int16_t i=align-1, p=size-7; i>=1; i--, p-=step) pos[i]=p;
+    for (uint8_t i=0; i<align; i++) {
+      for (uint8_t j=0; j<align; j++) {
+        if ((i==0 && j==0) || (i==0 && j==align-1) || (i==align-1 && j==0)) continue;
+        for (int8_t dy=-2; dy<=2; dy++) {
+          for (int8_t dx=-2; dx<=2; dx++) {
+            setFunction(modules,isFunction,size,pos[i]+dx,pos[j]+dy,(abs(dx)>abs(dy) ? abs(dx) : abs(dy))!=1);
+          }
+        }
+      }
+    }
+  }
+  drawFormat(modules,isFunction,size,0,0); //reserve the format areas, drawn for real once the mask is known
+  if (version>=7) {
+    uint32_t rem=version;
+    for (uint8_t i=0; i<12; i++) rem=(rem<<1)^((rem>>11)*0x1F25);
+    uint32_t bits=((uint32_t)version<<12)|(rem&0xFFF);
+    for (uint8_t i=0; i<18; i++) {
+      bool on=(bits>>i)&1;
+      uint8_t a=size-11+i%3, b=i/3;
+      setFunction(modules,isFunction,size,a,b,on);
+      setFunction(modules,isFunction,size,b,a,on);
+    }
+  }
+}
+
+static bool maskBit(uint8_t mask, uint8_t x, uint8_t y) {
+  switch (mask) {
+    case 0: return (x+y)%2==0;
+    case 1: return y%2==0;
+    case 2: return x%3==0;
+    case 3: return (x+y)%3==0;
+    case 4: return (x/3+y/2)%2==0;
+    case 5: return (x*y)%2+(x*y)%3==0;
+    case 6: return ((x*y)%2+(x*y)%3)%2==0;
+    default: return ((x+y)%2+(x*y)%3)%2==0;
+  }
+}
+
+static void applyMask(uint8_t *modules, const uint8_t *isFunction, uint8_t size, uint8_t mask) {
+  for (uint8_t y=0; y<size; y++) {
+    for (uint8_t x=0; x<size; x++) {
+      if (!gridGet(isFunction,size,x,y) && maskBit(mask,x,y)) gridSet(modules,size,x,y,!gridGet(modules,size,x,y));
+    }
+  }
+}
+
+//ISO 18004 penalty: runs of 5+, 2x2 blocks, finder-like 1:1:3:1:1 patterns with 4 light modules on a
+//side, and the dark/light balance
+static uint32_t penalty(const uint8_t *modules, uint8_t size) {
+  uint32_t score=0;
+  for (uint8_t pass=0; pass<2; pass++) {
+    for (uint8_t a=0; a<size; a++) {
+      uint8_t run=0;
+      bool last=false;
+      uint16_t window=0;
+      for (uint8_t b=0; b<size; b++) {
+        bool on=pass ? gridGet(modules,size,a,b) : gridGet(modules,size,b,a);
+        if (b>0 && on==last) {
+          run++;
+          if (run==5) score+=3;
+          else if (run>5) score++;
+        } else {
+          run=1;
+          last=on;
+        }
+        window=((window<<1)|on)&0x7FF;
+        if (b>=10 && (window==0x05D || window==0x5D0)) score+=40;
+      }
+    }
+  }
+  for (uint8_t y=0; y+1<size; y++) {
+    for (uint8_t x=0; x+1<size; x++) {
+      bool c=gridGet(modules,size,x,y);
+      if (c==gridGet(modules,size,x+1,y) && c==gridGet(modules,size,x,y+1) && c==gridGet(modules,size,x+1,y+1)) score+=3;
+    }
+  }
+  uint32_t dark=0, total=(uint32_t)size*size;
+  for (uint8_t y=0; y<size; y++) for (uint8_t x=0; x<size; x++) dark+=gridGet(modules,size,x,y);
+  uint32_t k=(abs((int32_t)(dark*20)-(int32_t)(total*10))+total-1)/total-1;
+  return score+k*10;
+}
+
+static uint8_t countBits(uint8_t mode, uint8_t version) {
+  uint8_t range=(version<10) ? 0 : (version<27) ? 1 : 2;
+  static const uint8_t bits[3][3]={{10,12,14},{9,11,13},{8,16,16}};
+  return bits[mode][range];
+}
+
+static int8_t encode(QRCode *qrcode, uint8_t *modules, uint8_t version, uint8_t ecc, const uint8_t *data, uint16_t length) {
+  if (version<1 || version>40 || ecc>3) return -1;
+  uint8_t size=version*4+17;
+  uint8_t mode=MODE_NUMERIC;
+  for (uint16_t i=0; i<length; i++) {
+    if (mode==MODE_NUMERIC && (data[i]<'0' || data[i]>'9')) mode=MODE_ALPHANUMERIC;
+    if (mode==MODE_ALPHANUMERIC && (data[i]==0 || strchr(alphanumeric,data[i])==NULL)) mode=MODE_BYTE;
+  }
+
+  uint16_t rawCodewords=rawDataModules(version)/8;
+  uint8_t blocks=eccBlocks[ecc][version], blockEcc=eccPerBlock[ecc][version];
+  uint16_t dataCodewords=rawCodewords-blocks*blockEcc;
+
+  uint8_t codewords[3706];
+  memset(codewords,0,sizeof(codewords));
+  BitBuffer bb={codewords,0};
+  bbAppend(&bb,(mode==MODE_NUMERIC) ? 1 : (mode==MODE_ALPHANUMERIC) ? 2 : 4,4);
+  uint8_t lenBits=countBits(mode,version);
+  if (length>=(1u<<lenBits)) return -1;
+  bbAppend(&bb,length,lenBits);
+  if (mode==MODE_NUMERIC) {
+    for (uint16_t i=0; i<length; i+=3) {
+      uint8_t n=(length-i<3) ? length-i : 3;
+      uint16_t v=0;
+      for (uint8_t j=0; j<n; j++) v=v*10+(data[i+j]-'0');
+      bbAppend(&bb,v,n*3+1);
+    }
+  } else if (mode==MODE_ALPHANUMERIC) {
+    for (uint16_t i=0; i<length; i+=2) {
+      uint16_t v=strchr(alphanumeric,data[i])-alphanumeric;
+      if (i+1<length) bbAppend(&bb,v*45+(strchr(alphanumeric,data[i+1])-alphanumeric),11);
+      else bbAppend(&bb,v,6);
+    }
+  } else {
+    for (uint16_t i=0; i<length; i++) bbAppend(&bb,data[i],8);
+  }
+  uint32_t capacity=(uint32_t)dataCodewords*8;
+  if (bb.bits>capacity) return -1;
+  bbAppend(&bb,0,(capacity-bb.bits<4) ? capacity-bb.bits : 4);
+  if (bb.bits%8) bbAppend(&bb,0,8-bb.bits%8);
+  for (uint8_t pad=0xEC; bb.bits<capacity; pad^=0xEC^0x11) bbAppend(&bb,pad,8);
+
+  //split into blocks (the last ones one codeword longer), add ECC to each and interleave
+  uint8_t interleaved[3706];
+  uint8_t shortBlocks=blocks-rawCodewords%blocks;
+  uint16_t shortLen=rawCodewords/blocks-blockEcc, at=0;
+  uint16_t starts[81];
+  uint8_t eccBytes[81][30];
+  uint16_t k=0;
+  for (uint8_t b=0; b<blocks; b++) {
+    uint16_t n=shortLen+(b>=shortBlocks);
+    starts[b]=k;
+    rsRemainder(codewords+k,n,blockEcc,eccBytes[b]);
+    k+=n;
+  }
+  for (uint16_t i=0; i<=shortLen; i++) {
+    for (uint8_t b=0; b<blocks; b++) {
+      if (i<shortLen || b>=shortBlocks) interleaved[at++]=codewords[starts[b]+i];
+    }
+  }
+  for (uint8_t i=0; i<blockEcc; i++) for (uint8_t b=0; b<blocks; b++) interleaved[at++]=eccBytes[b][i];
+
+  uint8_t isFunction[GRID_BYTES];
+  uint16_t gridBytes=qrcode_getBufferSize(version);
+  memset(modules,0,gridBytes);
+  memset(isFunction,0,gridBytes);
+  drawFunctionPatterns(modules,isFunction,version,size);
+
+  //zigzag the codewords up and down two-module columns from the right, skipping the timing column
+  uint32_t bit=0;
+  for (int16_t right=size-1; right>=1; right-=2) {
+    if (right==6) right=5;
+    for (uint8_t vert=0; vert<size; vert++) {
+      for (uint8_t j=0; j<2; j++) {
+        uint8_t x=right-j;
+        bool upward=((right+1)&2)==0;
+        uint8_t y=upward ? size-1-vert : vert;
+        if (!gridGet(isFunction,size,x,y) && bit<(uint32_t)at*8) {
+          gridSet(modules,size,x,y,(interleaved[bit>>3]>>(7-(bit&7)))&1);
+          bit++;
+        }
+      }
+    }
+  }
+
+  int8_t mask=qrcodeHostMask;
+  if (mask<0 || mask>7) {
+    uint32_t best=0xFFFFFFFF;
+    for (uint8_t m=0; m<8; m++) {
+      applyMask(modules,isFunction,size,m);
+      drawFormat(modules,isFunction,size,ecc,m);
+      uint32_t p=penalty(modules,size);
+      if (p<best) {
+        best=p;
+        mask=m;
+      }
+      applyMask(modules,isFunction,size,m);
+    }
+  }
+  applyMask(modules,isFunction,size,mask);
+  drawFormat(modules,isFunction,size,ecc,mask);
+
+  qrcode->version=version;
+  qrcode->size=size;
+  qrcode->ecc=ecc;
+  qrcode->mode=mode;
+  qrcode->mask=mask;
+  qrcode->modules=modules;
+  return 0;
+}
+
+int8_t qrcode_initBytes(QRCode *qrcode, uint8_t *modules, uint8_t version, uint8_t ecc, uint8_t *data, uint16_t length) {
+  return encode(qrcode,modules,version,ecc,data,length);
+}
+
+int8_t qrcode_initText(QRCode *qrcode, uint8_t *modules, uint8_t version, uint8_t ecc, const char *data) {
+  return encode(qrcode,modules,version,ecc,(const uint8_t*)data,strlen(data));
+}
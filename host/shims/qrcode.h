@@ -0,0 +1,45 @@
+/*
+ * QRCode (host)
+ */
+
+//same API as ricmoo's QRCode library the sketch builds against on the ESP32: byte, alphanumeric or
+//numeric mode picked from the text, Reed-Solomon ECC, lowest-penalty mask. modules are stored one bit
+//each, row major, most significant bit first
+
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+
+#define ECC_LOW 0
+#define ECC_MEDIUM 1
+#define ECC_QUARTILE 2
+#define ECC_HIGH 3
+
+#define MODE_NUMERIC 0
+#define MODE_ALPHANUMERIC 1
+#define MODE_BYTE 2
+
+typedef struct QRCode {
+  uint8_t version;
+  uint8_t size;
+  uint8_t ecc;
+  uint8_t mode;
+  uint8_t mask;
+  uint8_t *modules;
+} QRCode;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+uint16_t qrcode_getBufferSize(uint8_t version);
+int8_t qrcode_initText(QRCode *qrcode, uint8_t *modules, uint8_t version, uint8_t ecc, const char *data);
+int8_t qrcode_initBytes(QRCode *qrcode, uint8_t *modules, uint8_t version, uint8_t ecc, uint8_t *data, uint16_t length);
+bool qrcode_getModule(QRCode *qrcode, uint8_t x, uint8_t y);
+
+//host only: force a mask (0-7) instead of choosing the lowest penalty one, -1 to choose again
+extern int8_t qrcodeHostMask;
+
+#ifdef __cplusplus
+}
+#endif
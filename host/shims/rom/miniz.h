@@ -0,0 +1,40 @@
+/*
+ * ROM miniz tinfl (host)
+ */
+
+//the ESP32 ROM's raw inflate API on top of zlib. tinfl_decompressor is padded to the size of the ROM's
+//struct so the sketch's malloc costs the same, zlib's own state lives outside the heap model. there is
+//only one inflate stream at a time, which is all the OTA path ever uses
+
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+
+#define TINFL_LZ_DICT_SIZE 32768
+
+enum {
+  TINFL_FLAG_PARSE_ZLIB_HEADER=1,
+  TINFL_FLAG_HAS_MORE_INPUT=2,
+  TINFL_FLAG_USING_NON_WRAPPING_OUTPUT_BUF=4
+};
+
+typedef enum {
+  TINFL_STATUS_BAD_PARAM=-3,
+  TINFL_STATUS_ADLER32_MISMATCH=-2,
+  TINFL_STATUS_FAILED=-1,
+  TINFL_STATUS_DONE=0,
+  TINFL_STATUS_NEEDS_MORE_INPUT=1,
+  TINFL_STATUS_HAS_MORE_OUTPUT=2
+} tinfl_status;
+
+typedef struct {
+  uint32_t m_state;
+  uint8_t rom[10996]; //sizeof the ROM's tinfl_decompressor
+} tinfl_decompressor;
+
+void tinfl_init(tinfl_decompressor *r);
+tinfl_status tinfl_decompress(tinfl_decompressor *r, const uint8_t *pIn_buf_next, size_t *pIn_buf_size, uint8_t *pOut_buf_start, uint8_t *pOut_buf_next, size_t *pOut_buf_size, uint32_t decomp_flags);
+
+//host only: how many bytes past the end of the deflate stream tinfl_decompress() reports as consumed
+//when it finishes. 0 is exact; the ROM's bit buffer can swallow up to 4 without giving them back
+extern uint8_t tinflHostLookahead;
@@ -0,0 +1,77 @@
+/*
+ * mbedtls SHA-256 (host)
+ */
+
+#include <mbedtls/sha256.h>
+#include <string.h>
+
+static const uint32_t k[64]={
+  0x428a2f98,0x71374491,0xb5c0fbcf,0xe9b5dba5,0x3956c25b,0x59f111f1,0x923f82a4,0xab1c5ed5,
+  0xd807aa98,0x12835b01,0x243185be,0x550c7dc3,0x72be5d74,0x80deb1fe,0x9bdc06a7,0xc19bf174,
+  0xe49b69c1,0xefbe4786,0x0fc19dc6,0x240ca1cc,0x2de92c6f,0x4a7484aa,0x5cb0a9dc,0x76f988da,
+  0x983e5152,0xa831c66d,0xb00327c8,0xbf597fc7,0xc6e00bf3,0xd5a79147,0x06ca6351,0x14292967,
+  0x27b70a85,0x2e1b2138,0x4d2c6dfc,0x53380d13,0x650a7354,0x766a0abb,0x81c2c92e,0x92722c85,
+  0xa2bfe8a1,0xa81a664b,0xc24b8b70,0xc76c51a3,0xd192e819,0xd6990624,0xf40e3585,0x106aa070,
+  0x19a4c116,0x1e376c08,0x2748774c,0x34b0bcb5,0x391c0cb3,0x4ed8aa4a,0x5b9cca4f,0x682e6ff3,
+  0x748f82ee,0x78a5636f,0x84c87814,0x8cc70208,0x90befffa,0xa4506ceb,0xbef9a3f7,0xc67178f2
+};
+
+static inline uint32_t ror(uint32_t x, uint8_t n) { return (x>>n)|(x<<(32-n)); }
+
+static void block(mbedtls_sha256_context *ctx, const uint8_t *p) {
+  uint32_t w[64];
+  for (uint8_t i=0; i<16; i++) w[i]=((uint32_t)p[i*4]<<24)|((uint32_t)p[i*4+1]<<16)|((uint32_t)p[i*4+2]<<8)|p[i*4+3];
+  for (uint8_t i=16; i<64; i++) {
+    uint32_t s0=ror(w[i-15],7)^ror(w[i-15],18)^(w[i-15]>>3), s1=ror(w[i-2],17)^ror(w[i-2],19)^(w[i-2]>>10);
+    w[i]=w[i-16]+s0+w[i-7]+s1;
+  }
+  uint32_t a=ctx->state[0], b=ctx->state[1], c=ctx->state[2], d=ctx->state[3];
+  uint32_t e=ctx->state[4], f=ctx->state[5], g=ctx->state[6], h=ctx->state[7];
+  for (uint8_t i=0; i<64; i++) {
+    uint32_t t1=h+(ror(e,6)^ror(e,11)^ror(e,25))+((e&f)^(~e&g))+k[i]+w[i];
+    uint32_t t2=(ror(a,2)^ror(a,13)^ror(a,22))+((a&b)^(a&c)^(b&c));
+    h=g; g=f; f=e; e=d+t1; d=c; c=b; b=a; a=t1+t2;
+  }
+  ctx->state[0]+=a; ctx->state[1]+=b; ctx->state[2]+=c; ctx->state[3]+=d;
+  ctx->state[4]+=e; ctx->state[5]+=f; ctx->state[6]+=g; ctx->state[7]+=h;
+}
+
+void mbedtls_sha256_init(mbedtls_sha256_context *ctx) { memset(ctx,0,sizeof(*ctx)); }
+void mbedtls_sha256_free(mbedtls_sha256_context *ctx) { memset(ctx,0,sizeof(*ctx)); }
+
+int mbedtls_sha256_starts(mbedtls_sha256_context *ctx, int is224) {
+  static const uint32_t init256[8]={0x6a09e667,0xbb67ae85,0x3c6ef372,0xa54ff53a,0x510e527f,0x9b05688c,0x1f83d9ab,0x5be0cd19};
+  static const uint32_t init224[8]={0xc1059ed8,0x367cd507,0x3070dd17,0xf70e5939,0xffc00b31,0x68581511,0x64f98fa7,0xbefa4fa4};
+  memcpy(ctx->state,is224 ? init224 : init256,sizeof(ctx->state));
+  ctx->total=0;
+  ctx->is224=is224;
+  return 0;
+}
+
+int mbedtls_sha256_update(mbedtls_sha256_context *ctx, const unsigned char *input, size_t ilen) {
+  size_t fill=ctx->total%64;
+  ctx->total+=ilen;
+  if (fill>0) {
+    size_t n=(64-fill<ilen) ? 64-fill : ilen;
+    memcpy(ctx->buffer+fill,input,n);
+    input+=n; ilen-=n;
+    if (fill+n<64) return 0;
+    block(ctx,ctx->buffer);
+  }
+  for (; ilen>=64; input+=64, ilen-=64) block(ctx,input);
+  memcpy(ctx->buffer,input,ilen);
+  return 0;
+}
+
+int mbedtls_sha256_finish(mbedtls_sha256_context *ctx, unsigned char output[32]) {
+  uint64_t bits=ctx->total*8;
+  uint8_t pad[72]={0x80};
+  size_t fill=ctx->total%64, n=(fill<56) ? 56-fill : 120-fill;
+  for (uint8_t i=0; i<8; i++) pad[n+i]=bits>>(56-8*i);
+  mbedtls_sha256_update(ctx,pad,n+8);
+  for (uint8_t i=0; i<(ctx->is224 ? 7 : 8); i++) {
+    output[i*4]=ctx->state[i]>>24; output[i*4+1]=ctx->state[i]>>16;
+    output[i*4+2]=ctx->state[i]>>8; output[i*4+3]=ctx->state[i];
+  }
+  return 0;
+}
@@ -0,0 +1,147 @@
+/*
+ * HTTP Message Parser
+ */
+
+//incremental http/1.1 parser used for both the incoming LNbits payment webhook (a request) and the
+//LNbits invoice API's reply (a response). bytes are fed in as they come off the socket and held in a
+//fixed buffer - header lines are dropped as soon as they're processed, so the buffer only ever has to
+//hold the longest header line or the body (sized by Content-Length). responses may also come
+//Transfer-Encoding: chunked (LNbits behind some proxies does), the chunks are joined in the same
+//buffer and each chunk-size line is dropped after it. nothing is allocated per message
+
+const uint16_t httpBufSize=2048, paymentHashLen=64;
+
+enum HttpState { HTTP_FIRST_LINE, HTTP_HEADERS, HTTP_BODY, HTTP_CHUNK_SIZE, HTTP_CHUNK_DATA, HTTP_TRAILER, HTTP_DONE, HTTP_ERROR };
+
+struct HttpParser {
+  HttpState state;
+  const char *expect; //what the first line has to start with, "POST " or "HTTP/1."
+  int16_t status; //response status code, 0 for requests
+  bool close; //peer sent Connection: close
+  bool chunked; //response sent Transfer-Encoding: chunked
+  uint16_t len, body; //bytes in buf / of them the chunked body so far, chunk-size lines go after it
+  int32_t contentLength; //or the size of the current chunk
+  char buf[httpBufSize];
+};
+
+void httpReset(HttpParser &p, const char *expect) {
+  p.state=HTTP_FIRST_LINE;
+  p.expect=expect;
+  p.status=0;
+  p.close=false;
+  p.chunked=false;
+  p.len=p.body=0;
+  p.contentLength=-1;
+}
+
+HttpState httpFeed(HttpParser &p, const uint8_t *data, size_t n) {
+  for (size_t i=0; i<n && p.state<HTTP_DONE; i++) {
+    if (p.len>=httpBufSize) {
+      p.state=HTTP_ERROR; //line or body too long for the buffer
+      break;
+    }
+    char c=data[i];
+    p.buf[p.len++]=c;
+    if (p.state==HTTP_BODY) {
+      if (p.len>=p.contentLength) p.state=HTTP_DONE;
+      continue;
+    }
+    if (p.state==HTTP_CHUNK_DATA) {
+      if (p.len>=p.body+p.contentLength) {
+        p.body=p.len;
+        p.state=HTTP_CHUNK_SIZE;
+      }
+      continue;
+    }
+    if (c!='\n') continue;
+
+    if (p.state==HTTP_CHUNK_SIZE || p.state==HTTP_TRAILER) {
+      //a chunk-size line (or trailer) after the body so far, parse it and drop it again
+      uint16_t end=p.len-1;
+      if (end>p.body && p.buf[end-1]=='\r') end--;
+      p.buf[end]='\0';
+      const char *line=p.buf+p.body;
+      p.len=p.body;
+      if (end==p.body) {
+        if (p.state==HTTP_TRAILER) p.state=HTTP_DONE; //blank line after the last chunk
+        continue; //or the CRLF closing the previous chunk's data
+      }
+      if (p.state==HTTP_TRAILER) continue; //trailer fields aren't used
+      char *stop;
+      long size=strtol(line,&stop,16); //"1a;ext=..." extensions are ignored
+      if (stop==line || size<0 || size>httpBufSize-p.body) p.state=HTTP_ERROR;
+      else if (size==0) p.state=HTTP_TRAILER;
+      else {
+        p.contentLength=size;
+        p.state=HTTP_CHUNK_DATA;
+      }
+      continue;
+    }
+
+
+    //end of a start/header line, strip the CRLF and process it
+    uint16_t end=p.len-1;
+    if (end>0 && p.buf[end-1]=='\r') end--;
+    p.buf[end]='\0';
+    if (p.state==HTTP_FIRST_LINE) {
+      if (strncmp(p.buf,p.expect,strlen(p.expect))!=0) {
+        p.state=HTTP_ERROR;
+      } else {
+        if (strncmp(p.buf,"HTTP/",5)==0 && end>=12) p.status=atoi(p.buf+9); //"HTTP/1.1 201 Created"
+        p.state=HTTP_HEADERS;
+      }
+    } else if (end==0) {
+      //blank line, headers are done. the body is chunked or sized by Content-Length, and it has to fit
+      if (p.chunked) p.state=HTTP_CHUNK_SIZE;
+      else if (p.contentLength<0 || p.contentLength>httpBufSize) p.state=HTTP_ERROR;
+      else p.state=(p.contentLength==0) ? HTTP_DONE : HTTP_BODY;
+    } else if (strncasecmp(p.buf,"content-length:",15)==0) {
+      p.contentLength=atol(p.buf+15);
+    } else if (strncasecmp(p.buf,"transfer-encoding:",18)==0) {
+      p.chunked=(p.status>0 && strcasestr(p.buf+18,"chunked")!=NULL); //webhook requests still need Content-Length
+    } else if (strncasecmp(p.buf,"connection:",11)==0) {
+      p.close=(strcasestr(p.buf+11,"close")!=NULL);
+    }
+    p.len=0;
+  }
+  return p.state;
+}
+
+//single pass over a JSON body looking for the top level string member key, copies its value into out
+//(outSize bytes incl. terminator). this is all we need from the payloads, so no JSON tree is built
+bool jsonString(const HttpParser &p, const char *key, char *out, uint16_t outSize) {
+  const char *b=p.buf;
+  uint16_t n=p.len, keyLen=strlen(key);
+  int16_t depth=0;
+  for (uint16_t i=0; i<n; i++) {
+    char c=b[i];
+    if (c=='{' || c=='[') {
+      depth++;
+    } else if (c=='}' || c==']') {
+      depth--;
+    } else if (c=='"') {
+      uint16_t start=++i;
+      while (i<n && b[i]!='"') {
+        if (b[i]=='\\') i++; //skip escaped char
+        i++;
+      }
+      if (i>=n) return false; //unterminated string
+      if (depth!=1 || (i-start)!=keyLen || memcmp(b+start,key,keyLen)!=0) continue;
+
+      //found the key, expect : and a string value
+      uint16_t j=i+1;
+      while (j<n && isspace((unsigned char)b[j])) j++;
+      if (j>=n || b[j]!=':') continue; //key text as a value, not a key
+      j++;
+      while (j<n && isspace((unsigned char)b[j])) j++;
+      if (j>=n || b[j]!='"') return false;
+      j++;
+      uint16_t k=0;
+      while (j<n && b[j]!='"' && k<outSize-1) out[k++]=b[j++];
+      if (j>=n || b[j]!='"') return false; //unterminated or too long for out
+      out[k]='\0';
+      return k>0;
+    }
+  }
+  return false;
+}
@@ -0,0 +1,99 @@
+/*
+ * Invoice Pool
+ */
+
+//invoices are created ahead of time by a background task so that a sale only has to take the next
+//one and draw it. every invoice in the pool stays outstanding until it's paid or expires, and a
+//webhook for any outstanding payment_hash counts as a sale. the pool is shared between the
+//invoice task (core 0) and loop() (core 1), so all access goes through the mutex
+
+const uint8_t invoicePoolSize=3;
+const uint16_t paymentRequestMax=1024;
+const uint8_t qrMaxVersion=18; //largest QR version (89x89) that still fits the panel at 2px per module
+const uint16_t qrBufferMax=((qrMaxVersion*4+17)*(qrMaxVersion*4+17)+7)/8; //same as qrcode_getBufferSize(qrMaxVersion)
+
+struct Invoice {
+  char hash[paymentHashLen+1];
+  char request[paymentRequestMax];
+  uint32_t expiry;
+  uint8_t qrVersion, qrEcc, qrSize;
+  uint8_t qrModules[qrBufferMax]; //QR matrix encoded once when the invoice is created, redraws reuse it
+  bool used, shown;
+};
+
+Invoice invoicePool[invoicePoolSize];
+SemaphoreHandle_t invoicePoolLock;
+
+void poolInit() {
+  invoicePoolLock=xSemaphoreCreateMutex();
+  for (uint8_t i=0; i<invoicePoolSize; i++) invoicePool[i].used=false;
+}
+
+//number of empty slots the invoice task should fill
+uint8_t poolFree() {
+  uint8_t n=0;
+  xSemaphoreTake(invoicePoolLock,portMAX_DELAY);
+  for (uint8_t i=0; i<invoicePoolSize; i++) if (!invoicePool[i].used) n++;
+  xSemaphoreGive(invoicePoolLock);
+  return n;
+}
+
+bool poolAdd(const Invoice &inv) {
+  bool added=false;
+  xSemaphoreTake(invoicePoolLock,portMAX_DELAY);
+  for (uint8_t i=0; i<invoicePoolSize; i++) {
+    if (!invoicePool[i].used) {
+      invoicePool[i]=inv;
+      invoicePool[i].used=true;
+      invoicePool[i].shown=false;
+      added=true;
+      break;
+    }
+  }
+  xSemaphoreGive(invoicePoolLock);
+  return added;
+}
+
+//take the ready invoice that expires last, mark it as the one on screen and copy it to out
+bool poolNext(Invoice &out) {
+  int8_t next=-1;
+  xSemaphoreTake(invoicePoolLock,portMAX_DELAY);
+  for (uint8_t i=0; i<invoicePoolSize; i++) {
+    if (invoicePool[i].used && !invoicePool[i].shown && (next<0 || invoicePool[i].expiry>invoicePool[next].expiry)) next=i;
+  }
+  if (next>=0) {
+    invoicePool[next].shown=true;
+    out=invoicePool[next];
+  }
+  xSemaphoreGive(invoicePoolLock);
+  return next>=0;
+}
+
+//a webhook came in for hash - if it's outstanding, remove it from the pool and return true
+bool poolRedeem(const char *hash) {
+  bool found=false;
+  xSemaphoreTake(invoicePoolLock,portMAX_DELAY);
+  for (uint8_t i=0; i<invoicePoolSize; i++) {
+    if (invoicePool[i].used && strcmp(invoicePool[i].hash,hash)==0) {
+      invoicePool[i].used=false;
+      found=true;
+      break;
+    }
+  }
+  xSemaphoreGive(invoicePoolLock);
+  return found;
+}
+
+//drop every invoice that has expired as of now (epoch seconds), returns how many were dropped
+uint8_t poolExpire(uint32_t now) {
+  uint8_t n=0;
+  xSemaphoreTake(invoicePoolLock,portMAX_DELAY);
+  for (uint8_t i=0; i<invoicePoolSize; i++) {
+    if (invoicePool[i].used && now>=invoicePool[i].expiry) {
+      invoicePool[i].used=false;
+      n++;
+    }
+  }
+  xSemaphoreGive(invoicePoolLock);
+  return n;
+}
@@ -0,0 +1,190 @@
+/*
+ * Sales Journal
+ */
+
+//append-only record of every sale in the "journal" flash partition (see partitions.csv). records are
+//written front to back through each 4KB sector and the sectors are used as a ring, so every sector
+//gets erased once per lap instead of the same one on every sale. sales are appended to a small RAM
+//batch by the webhook handler and written out together by journalFlush() from loop().
+//
+//a record is only valid if its magic and CRC check out, so a write torn by a power cut is simply
+//skipped at boot. the newest valid record (highest seq) tells journalBegin() where to carry on.
+//journalNext() reads the ring back oldest first, for reconciling sales against LNbits (GET /journal)
+
+#include <esp_partition.h>
+
+const uint32_t journalMagic=0x4C4E4331; //"LNC1"
+const uint16_t journalSectorSize=4096;
+const uint8_t journalBatchMax=8;
+const uint16_t journalFlushAfter=2000; //ms a sale may sit in the batch before it's written
+
+struct JournalRecord {
+  uint32_t magic;
+  uint32_t seq;
+  uint32_t epoch;
+  uint32_t amount; //sats
+  uint8_t hash[32]; //payment_hash, binary
+  uint8_t reserved[12];
+  uint32_t crc; //crc32 of everything above
+};
+const uint16_t journalRecsPerSector=journalSectorSize/sizeof(JournalRecord);
+
+const esp_partition_t *journalPart;
+uint16_t journalSectors, journalSector, journalSlot; //where the next record goes
+uint32_t journalNextSeq;
+JournalRecord journalBatch[journalBatchMax];
+uint8_t journalPending;
+uint32_t journalPendingSince;
+
+uint32_t journalCrc(const uint8_t *data, size_t len) {
+  uint32_t crc=0xFFFFFFFF;
+  while (len--) {
+    crc^=*data++;
+    for (uint8_t i=0; i<8; i++) crc=(crc>>1)^(0xEDB88320 & (0-(crc&1)));
+  }
+  return ~crc;
+}
+
+bool journalValid(const JournalRecord &rec) {
+  return rec.magic==journalMagic && rec.crc==journalCrc((const uint8_t*)&rec,offsetof(JournalRecord,crc));
+}
+
+bool journalBlank(const JournalRecord &rec) {
+  const uint8_t *b=(const uint8_t*)&rec;
+  for (uint16_t i=0; i<sizeof(JournalRecord); i++) if (b[i]!=0xFF) return false;
+  return true;
+}
+
+uint32_t journalOffset(uint16_t sector, uint16_t slot) {
+  return (uint32_t)sector*journalSectorSize+(uint32_t)slot*sizeof(JournalRecord);
+}
+
+//find the partition and the newest valid record. seedSeq is where numbering starts on an empty
+//journal (e.g. the old EEPROM counter), returns the number of the last sale recorded
+uint32_t journalBegin(uint32_t seedSeq) {
+  journalPart=esp_partition_find_first(ESP_PARTITION_TYPE_DATA,(esp_partition_subtype_t)0x40,"journal");
+  if (journalPart==NULL) {
+    Serial.println("no journal partition, sales won't be recorded");
+    journalNextSeq=seedSeq+1;
+    return seedSeq;
+  }
+  journalSectors=journalPart->size/journalSectorSize;
+
+  bool found=false;
+  uint32_t lastSeq=seedSeq;
+  uint16_t headSector=0, headSlot=0;
+  JournalRecord rec;
+  for (uint16_t sector=0; sector<journalSectors; sector++) {
+    for (uint16_t slot=0; slot<journalRecsPerSector; slot++) {
+      esp_partition_read(journalPart,journalOffset(sector,slot),&rec,sizeof(rec));
+      if (journalValid(rec) && (!found || rec.seq>lastSeq)) {
+        found=true;
+        lastSeq=rec.seq;
+        headSector=sector; headSlot=slot;
+      }
+    }
+  }
+
+  if (!found) {
+    //empty (or unreadable) journal, start over at the front
+    esp_partition_erase_range(journalPart,0,journalSectorSize);
+    journalSector=0; journalSlot=0;
+  } else {
+    //carry on at the first blank slot after the newest record, skipping anything torn
+    journalSector=headSector; journalSlot=headSlot+1;
+    while (journalSlot<journalRecsPerSector) {
+      esp_partition_read(journalPart,journalOffset(journalSector,journalSlot),&rec,sizeof(rec));
+      if (journalBlank(rec)) break;
+      journalSlot++;
+    }
+  }
+  journalNextSeq=lastSeq+1;
+  Serial.printf("journal: %d sectors, last sale #%u, next write at %d/%d\n",journalSectors,lastSeq,journalSector,journalSlot);
+  return lastSeq;
+}
+
+//64 hex chars (payment_hash, sha256) to 32 bytes, zeros if it isn't one
+void hashFromHex(const char *hex, uint8_t *out) {
+  memset(out,0,32);
+  if (strlen(hex)!=64) return;
+  for (uint8_t i=0; i<64; i++) {
+    char c=tolower(hex[i]);
+    uint8_t v;
+    if (c>='0' && c<='9') v=c-'0';
+    else if (c>='a' && c<='f') v=c-'a'+10;
+    else { memset(out,0,32); return; }
+    out[i/2]|=(i&1) ? v : (v<<4);
+  }
+}
+
+//32 bytes to 64 lowercase hex chars plus terminator
+void hashToHex(const uint8_t *hash, char *out) {
+  for (uint8_t i=0; i<32; i++) {
+    out[i*2]="0123456789abcdef"[hash[i]>>4];
+    out[i*2+1]="0123456789abcdef"[hash[i]&0x0F];
+  }
+  out[64]='\0';
+}
+
+//walk the ring from the oldest sector to the head: start with at=0 and call until it returns false,
+//rec is the next valid record each time. torn and blank slots are skipped. doesn't see the batch, so
+//journalFlush(true) first
+bool journalNext(uint32_t &at, JournalRecord &rec) {
+  if (journalPart==NULL) return false;
+  uint32_t slots=(uint32_t)journalSectors*journalRecsPerSector, first=(uint32_t)((journalSector+1)%journalSectors)*journalRecsPerSector;
+  while (at<slots) {
+    uint32_t slot=(first+at++)%slots;
+    esp_partition_read(journalPart,journalOffset(slot/journalRecsPerSector,slot%journalRecsPerSector),&rec,sizeof(rec));
+    if (journalValid(rec)) return true;
+  }
+  return false;
+}
+
+//one record as a CSV line, seq,epoch,payment_hash,amount
+int journalCsv(const JournalRecord &rec, char *out, size_t size) {
+  char hex[65];
+  hashToHex(rec.hash,hex);
+  return snprintf(out,size,"%u,%u,%s,%u\n",rec.seq,rec.epoch,hex,rec.amount);
+}
+
+//write the batch if it's been waiting journalFlushAfter ms (or force), one flash write per sector touched
+void journalFlush(bool force) {
+  if (journalPending==0 || journalPart==NULL) {
+    journalPending=0;
+    return;
+  }
+  if (!force && (millis()-journalPendingSince)<journalFlushAfter) return;
+
+  uint8_t done=0;
+  while (done<journalPending) {
+    if (journalSlot>=journalRecsPerSector) {
+      //sector full, move on and erase the next one (the oldest records in the ring)
+      journalSector=(journalSector+1)%journalSectors;
+      journalSlot=0;
+      esp_partition_erase_range(journalPart,journalOffset(journalSector,0),journalSectorSize);
+    }
+    uint8_t n=journalPending-done;
+    if (n>journalRecsPerSector-journalSlot) n=journalRecsPerSector-journalSlot;
+    esp_err_t err=esp_partition_write(journalPart,journalOffset(journalSector,journalSlot),&journalBatch[done],n*sizeof(JournalRecord));
+    if (err!=ESP_OK) Serial.printf("journal write failed: %d\n",err);
+    journalSlot+=n;
+    done+=n;
+  }
+  journalPending=0;
+}
+
+//add a sale to the batch, returns its sequence number. doesn't touch flash unless the batch is full
+uint32_t journalAppend(uint32_t epoch, const char *hash, uint32_t amount) {
+  if (journalPending>=journalBatchMax) journalFlush(true);
+  JournalRecord &rec=journalBatch[journalPending];
+  memset(&rec,0xFF,sizeof(rec));
+  rec.magic=journalMagic;
+  rec.seq=journalNextSeq++;
+  rec.epoch=epoch;
+  rec.amount=amount;
+  hashFromHex(hash,rec.hash);
+  rec.crc=journalCrc((const uint8_t*)&rec,offsetof(JournalRecord,crc));
+  if (journalPending==0) journalPendingSince=millis();
+  journalPending++;
+  return rec.seq;
+}
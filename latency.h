@@ -0,0 +1,65 @@
+/*
+ * Sale Latency
+ */
+
+//end to end timing of the payment path, measured on the machine itself: webhook arrival to servo
+//start (payment->dispense) and webhook arrival to the next QR code being on screen (payment->next QR)
+//for the last saleLatencyLen sales. send "stats" in the serial console for p50/p99.
+//
+//every sale carries its own arrival time: the dispense task gets it with the dispense command and
+//records when that command actually starts the servo, and loop() keeps the sales still waiting for a
+//new QR code in a small FIFO. so back-to-back sales each get their own sample, and a sale that can't
+//be timed is skipped rather than recorded as 0
+
+const uint8_t saleLatencyLen=32, latencyPendingMax=8;
+
+struct LatencyRing {
+  uint32_t samples[saleLatencyLen]; //us
+  uint32_t count;
+};
+
+LatencyRing dispenseLatency, qrLatency; //written only by the dispense task / loop() respectively
+int64_t latencyPending[latencyPendingMax]; //arrival times of sales waiting for the next QR, loop() only
+uint8_t latencyPendingCount;
+
+void latencyRecord(LatencyRing &ring, uint32_t us) {
+  ring.samples[ring.count%saleLatencyLen]=us;
+  ring.count++;
+}
+
+//a sale's webhook arrived at paidAt, it's timed when the next QR code goes up
+void latencySalePaid(int64_t paidAt) {
+  if (latencyPendingCount<latencyPendingMax) latencyPending[latencyPendingCount++]=paidAt;
+}
+
+//a new QR code is on screen (at now), which is the next one for every sale still waiting
+void latencyQRShown(int64_t now) {
+  for (uint8_t i=0; i<latencyPendingCount; i++) {
+    if (now>latencyPending[i]) latencyRecord(qrLatency,now-latencyPending[i]);
+  }
+  latencyPendingCount=0;
+}
+
+//pct percentile (0-100) of the samples in ring, in us. nearest rank: the smallest sample with at least
+//pct% of the samples at or below it, the same definition the host benchmarks use (host/harness.h)
+uint32_t latencyPercentile(const LatencyRing &ring, uint8_t pct) {
+  uint8_t n=(ring.count<saleLatencyLen) ? ring.count : saleLatencyLen;
+  if (n==0) return 0;
+  uint32_t sorted[saleLatencyLen];
+  for (uint8_t i=0; i<n; i++) {
+    uint32_t v=ring.samples[i];
+    uint8_t j=i;
+    while (j>0 && sorted[j-1]>v) {
+      sorted[j]=sorted[j-1];
+      j--;
+    }
+    sorted[j]=v;
+  }
+  uint16_t rank=((uint16_t)n*pct+99)/100;
+  return sorted[(rank>0) ? rank-1 : 0];
+}
+
+void latencyReport() {
+  Serial.printf("payment->dispense p50 %u ms, p99 %u ms (last %d of %u sales)\n",latencyPercentile(dispenseLatency,50)/1000,latencyPercentile(dispenseLatency,99)/1000,(dispenseLatency.count<saleLatencyLen) ? dispenseLatency.count : saleLatencyLen,dispenseLatency.count);
+  Serial.printf("payment->next QR  p50 %u ms, p99 %u ms (last %d of %u sales)\n",latencyPercentile(qrLatency,50)/1000,latencyPercentile(qrLatency,99)/1000,(qrLatency.count<saleLatencyLen) ? qrLatency.count : saleLatencyLen,qrLatency.count);
+}
@@ -1,14 +1,23 @@
 #include <WiFi.h>
 #include <WiFiUdp.h>
 #include <NTPClient.h>
-#include <HTTPClient.h>
-#include <Arduino_JSON.h>
+#include <WiFiClientSecure.h>
 #include <GxEPD2_BW.h>
 #include "qrcode.h"
 #include <Fonts/FreeMonoBold9pt7b.h>
 #include <Servo.h>
 #include <EEPROM.h>
-#include "dorian.h"
+#include <esp_timer.h>
+
+const bool debug=true; //set to true for serial debugging output, also seen by the headers below
+
+#include "assets.h"
+#include "metrics.h"
+#include "httpparser.h"
+#include "invoices.h"
+#include "latency.h"
+#include "dispense.h"
+#include "journal.h"
 
 //OTA updates
 #include <WebServer.h>
@@ -16,12 +25,15 @@
 #include <ESPmDNS.h>
 #include <Update.h>
 #include "ota.h"
+#include "otastream.h"
 
 WiFiUDP ntpUDP;
 NTPClient timeClient(ntpUDP);
 WiFiServer webhookServer(39780); //webhook listener (for monitoring payments)
 WebServer ota(80);
 Servo servo;
+WiFiClientSecure lnbitsTLS; //one keep-alive connection to LNbits, only used by the invoice task
+HttpParser webhook;
 
 //BUSY->25, RST->26, DC->27, CS->15, CLK->13, DIN->14
 GxEPD2_BW<GxEPD2_154_D67, GxEPD2_154_D67::HEIGHT> display(GxEPD2_154_D67(15,27,26,25));
@@ -30,16 +42,51 @@ const char *ssid="yourwifissid", *pass="yourwifipass", *lnBitsAPIKey="yourlnbits
 const char *LNhost="lnbits.com", *invoiceEndpoint="https://lnbits.com/api/v1/payments", *thisHost="lncandy";
 
 const uint32_t invoiceExpOffset=(24*60*60); //LNbits invoices expire after 24 hours - after this period, we request a new invoice and generate new QR code
-const uint16_t webhookTimeout=2000, candyCost=25, maxInvRetries=10, invoiceRetryWait=30, servoRunFor=1050; //(PB M&Ms=1050)
+const uint16_t webhookTimeout=2000, lnbitsTimeout=10000, candyCost=25, invoiceRetryWait=30, servoRunFor=1050; //(PB M&Ms=1050)
+const int lnbitsConnectFailed=-1, lnbitsReadFailed=-11; //same codes HTTPClient used, so the error screen reads the same
+const uint16_t invoiceBackoffMin=1000, progressRedrawEvery=1000; //ms, first retry backoff (doubles up to invoiceRetryWait s) / progress bar redraw rate
 const int16_t servoRotation=-180; //pos=clockwise, neg=counter-clockwise (counter for great northern gumball machine)
+const uint8_t fullRefreshEvery=10; //partial e-paper refreshes allowed before a full refresh to clear ghosting
+const uint8_t qrAreaY=16, qrArea=184; //QR code gets the 200x184 area below the "SCAN TOP PAY" banner
 
-const bool debug=true; //set to true for serial debugging output
+//QR alphanumeric capacity (chars) for versions 1-qrMaxVersion, indexed [version-1][ecc] with ecc in
+//qrcode.h order (ECC_LOW, ECC_MEDIUM, ECC_QUARTILE, ECC_HIGH)
+const uint16_t qrAlnumCapacity[qrMaxVersion][4]={
+  {25,20,16,10}, {47,38,29,20}, {77,61,47,35}, {114,90,67,50}, {154,122,87,64}, {195,154,108,84},
+  {224,178,125,93}, {279,221,157,122}, {335,262,189,143}, {395,311,221,174}, {468,366,259,200},
+  {535,419,296,227}, {619,483,352,259}, {667,528,376,283}, {758,600,426,321}, {854,656,470,365},
+  {938,734,531,408}, {1046,816,574,452}
+};
 
-String paymentHash, paymentRequest, tempString;
-uint32_t invoiceExpiry, unitsSold, servoStartedAt;
+uint32_t unitsSold;
+esp_timer_handle_t servoTimer;
+TaskHandle_t loopTask, invoiceTask; //for stack high-water marks on /metrics
+char otaResult[256]; //reply to the last /update, OK/FAIL plus throughput and sha256
+bool otaOk;
+
+Invoice currentInvoice; //the invoice currently on screen
+bool invoiceShown=false, invoiceErrorShown=false;
+enum InvoiceState { INV_IDLE, INV_REQUESTING, INV_BACKOFF };
+volatile InvoiceState invoiceState=INV_IDLE; //what the invoice task is doing, written only by the task
+volatile int invoiceStatus; //http status of the last failed invoice request
+volatile uint16_t invoiceFailures; //consecutive failed invoice requests
+volatile uint32_t invoiceBackoffStart, invoiceBackoffFor; //millis() the current backoff started / its length in ms
+uint16_t shownFailures; //invoiceFailures as of the last error screen
+uint8_t progressShown; //percent the backoff progress bar was last drawn at
+uint32_t progressDrawnAt;
+uint8_t partialRefreshes; //partial refreshes since the last full one
+bool qrOnScreen=false; //the QR screen is up, so a new QR only has to repaint the code itself
 
 int16_t tbx,tby; uint16_t tbw,tbh,x,y;
 
+//fixed banners are laid out once by layoutBanners() at boot, drawBanner() just sets the cursor and prints
+enum BannerId { BANNER_SCAN, BANNER_ENJOY, BANNER_INV_ERR };
+struct Banner {
+  const char *text;
+  int16_t yOffset, x, y;
+};
+Banner banners[]={{"SCAN TOP PAY",92,0,0}, {"ENJOY YOUR CANDY",-188,0,0}, {"INV. CREATE ERR",32,0,0}};
+
 void setup() {
   Serial.begin(115200);
   SPI.end(); // release standard SPI pins, e.g. SCK(18), MISO(19), MOSI(23), SS(5)
@@ -49,6 +96,7 @@ void setup() {
   display.setRotation(1);
   display.setFont(&FreeMonoBold9pt7b);
   display.setTextColor(GxEPD_BLACK);
+  layoutBanners();
   display.setFullWindow();
   showDorian(true);
   
@@ -59,23 +107,39 @@ void setup() {
   }
 
   display.fillScreen(GxEPD_WHITE);
-  tempString=WiFi.localIP().toString(); displayText(tempString,0,0,true);
+  IPAddress addr=WiFi.localIP();
+  char ip[16]; snprintf(ip,sizeof(ip),"%d.%d.%d.%d",addr[0],addr[1],addr[2],addr[3]); displayText(ip,0,0,true);
   Serial.println(""); Serial.print("WiFi connected, "); Serial.print("IP address: "); Serial.println(WiFi.localIP());
   delay(1000);
   timeClient.begin();
+  timeClient.update();
   webhookServer.begin();
   
+  //sales are recorded in the journal partition now, the old EEPROM counter only seeds the sale
+  //numbering the first time the journal is used
   EEPROM.begin(32);
   EEPROM.get(0, unitsSold);
-  if (unitsSold == -1) {
-    //no value stored in EEPROM, set to 0
-    unitsSold++;
-    EEPROM.put(0, unitsSold); EEPROM.commit();
-  }
+  if (unitsSold == 0xFFFFFFFF) unitsSold=0; //no value stored in EEPROM
+  unitsSold=journalBegin(unitsSold);
+
+  //dispense engine runs on core 0, the servo is stopped by a one-shot esp_timer so the total
+  //servo rotation doesn't depend on what the main loop is doing
+  esp_timer_create_args_t servoTimerArgs={};
+  servoTimerArgs.callback=dispenseTimerFired;
+  servoTimerArgs.name="servoStop";
+  esp_timer_create(&servoTimerArgs,&servoTimer);
+  dispenseInit({servoStart,servoStop,esp_timer_get_time,servoArm});
 
-  //create the task on core 0 that monitors for servo stop timing
-  //putting this on a different core allows finer tuned control of total servo rotation
-  xTaskCreatePinnedToCore(stopServo,"stopServo",10000,NULL,0,NULL,0); 
+  //create the task on core 0 that keeps the invoice pool topped up, so a sale never waits on LNbits
+  poolInit();
+  if (buildInvoiceRequest()) {
+    xTaskCreatePinnedToCore(fillInvoicePool,"fillInvoicePool",12000,NULL,1,&invoiceTask,0);
+  } else {
+    Serial.println("invoice endpoint/API key/webhook settings too long for the request buffers, no invoices");
+    invoiceStatus=lnbitsConnectFailed;
+    invoiceFailures=1; //puts the error screen up
+  }
+  loopTask=xTaskGetCurrentTaskHandle(); //setup() runs on the loop task
   
   if (!MDNS.begin(thisHost)) {
     Serial.println("Error setting up MDNS responder!");
@@ -85,33 +149,41 @@ void setup() {
   }
   Serial.println("mDNS responder started");
   //return index page which is stored in Index
+  ota.on("/metrics", HTTP_GET, handleMetrics);
+  ota.on("/journal", HTTP_GET, handleJournal);
   ota.on("/", HTTP_GET, []() {
     ota.sendHeader("Connection", "close");
     ota.send(200, "text/html", serverIndex);
   });
-  //handling uploading firmware file
+  //handling uploading firmware file, a .bin or a gzip'd .bin (see otastream.h). the page passes the
+  //image's sha256 as a query parameter, a mismatch fails the update without touching the boot partition
+  otaInit();
   ota.on("/update", HTTP_POST, []() {
     ota.sendHeader("Connection", "close");
-    ota.send(200, "text/plain", (Update.hasError()) ? "FAIL" : "OK");
+    ota.send(200, "text/plain", otaResult);
+    if (!otaOk) return;
+    //don't reboot mid-sale, let the servo finish and get the journal onto flash first
+    while (!dispenseIdle()) delay(10);
+    journalFlush(true);
+    delay(100);
     ESP.restart();
   }, []() {
     HTTPUpload& upload = ota.upload();
     if (upload.status == UPLOAD_FILE_START) {
       Serial.printf("Update: %s\n", upload.filename.c_str());
-      if (!Update.begin(UPDATE_SIZE_UNKNOWN)) { //start with max available size
-        Update.printError(Serial);
-      }
+      otaOk=false;
+      snprintf(otaResult,sizeof(otaResult),"FAIL: no upload");
+      otaBegin(ota.arg("sha256").c_str());
     } else if (upload.status == UPLOAD_FILE_WRITE) {
-      //flashing firmware to ESP
-      if (Update.write(upload.buf, upload.currentSize) != upload.currentSize) {
-        Update.printError(Serial);
-      }
+      //flash writes happen on the otaWriter task, meanwhile keep taking payments
+      otaWrite(upload.buf, upload.currentSize);
+      handleWebhook();
     } else if (upload.status == UPLOAD_FILE_END) {
-      if (Update.end(true)) { //true to set the size to the current progress
-        Serial.printf("Update Success: %u\nRebooting...\n", upload.totalSize);
-      } else {
-        Update.printError(Serial);
-      }
+      otaOk=otaEnd(otaResult,sizeof(otaResult));
+      Serial.println(otaResult);
+    } else if (upload.status == UPLOAD_FILE_ABORTED) {
+      otaAbort();
+      snprintf(otaResult,sizeof(otaResult),"FAIL: upload aborted");
     }
   });
   ota.begin();
@@ -121,62 +193,75 @@ void loop() {
   handleWebhook();
   checkSerialIn();
   timeClient.update();
-  if ((timeClient.getEpochTime()>=invoiceExpiry)) {
-    Serial.println("invoice expired, creating a new one");
-    paymentHash=createInvoice();
-    display.hibernate();
+  invoiceExpiredTotal+=poolExpire(timeClient.getEpochTime());
+  if (invoiceShown && timeClient.getEpochTime()>=currentInvoice.expiry) {
+    Serial.println("invoice expired, showing a new one");
+    invoiceShown=false;
   }
+  if (!invoiceShown) showNextInvoice();
+  journalFlush(false);
   ota.handleClient(); //testing OTA
 }
 
 void handleWebhook() {
+  //the client allocates its socket handle and receive buffer (3 blocks, freed at client.stop()), the
+  //only heap use left per sale - parsing, the pool, the journal and drawing run on fixed buffers
   WiFiClient client=webhookServer.available();
   if (client) {
     uint32_t start=millis();
+    int64_t arrivedAt=esp_timer_get_time();
     Serial.println("!!POSSIBLE PAYMENT INCOMING!!");
-    String currentLine="";
-    bool inJsonBody=false;
-    JSONVar respBody;
+    httpReset(webhook,"POST ");
+    uint8_t chunk[128];
+    uint32_t parseTime=0; //us spent in the parser, not waiting on the network
     
-    //here we're parsing the post body until we've assembled what passes as a valid JSON object
-    //meaning that we've received the whole body
-    while (client.connected() && ((start+webhookTimeout)>millis())) {
-      if (client.available()) {
-        char c=client.read();
-        if (debug) Serial.write(c);
-        if (c=='{' && !inJsonBody) {
-          inJsonBody=true;
-          currentLine+=c;
-        } else if (inJsonBody && c!='\n' && c!='\r') {
-          currentLine+=c; 
+    //feed the request through the parser as it arrives, until it has seen the whole body
+    //(per Content-Length) or the request turns out to be malformed
+    while ((client.connected() || client.available()) && (millis()-start)<webhookTimeout) {
+      int avail=client.available();
+      if (avail>0) {
+        int n=client.read(chunk,(avail<(int)sizeof(chunk)) ? avail : sizeof(chunk));
+        if (n>0) {
+          uint32_t t=micros();
+          HttpState state=httpFeed(webhook,chunk,n);
+          parseTime+=micros()-t;
+          if (state>=HTTP_DONE) break;
         }
       }
-      respBody=JSON.parse(currentLine);
-      if (JSON.typeof(respBody)!="undefined") break; //we've received a valid json object, exit the loop
     }
     
-    if (debug) {
-      Serial.print("possibile payment object: "); Serial.println(currentLine);
+    if (debug && webhook.state==HTTP_DONE) {
+      Serial.print("possibile payment object: "); Serial.write((const uint8_t*)webhook.buf,webhook.len); Serial.println();
     }
     
-    if (JSON.typeof(respBody)!="undefined") {
+    char hash[paymentHashLen+1];
+    uint32_t t=micros();
+    bool gotHash=(webhook.state==HTTP_DONE && jsonString(webhook,"payment_hash",hash,sizeof(hash)));
+    metricRecord(webhookParseHist,parseTime+(micros()-t));
+    if (gotHash) {
       //does the payment hash we received in the webhook post body match the payment hash
-      //we're expecting (i.e. the payment hash of the current invoice)
-      if (respBody["payment_hash"]==paymentHash) {
-        //valid payment received, respond http 200, dispense candy, create and display new invoice
+      //of one of our outstanding invoices
+      if (poolRedeem(hash)) {
+        //valid payment received, respond http 200, dispense candy, display the next invoice
         client.println("HTTP/1.1 200 OK");
         client.println("Content-type:text/html");
         client.println("Connection: close");
         client.println(); client.println();
-        unitsSold++;
-        dispenseCandy();
-        Serial.println("payment_hash confirmed, dispense candy and create new invoice");
+        dispenseCandy(arrivedAt);
+        latencySalePaid(arrivedAt);
+        unitsSold=journalAppend(timeClient.getEpochTime(),hash,candyCost);
+        Serial.println("payment_hash confirmed, dispense candy and show next invoice");
         showDorian(false);
         Serial.print("units sold: "); Serial.println(unitsSold);
-        EEPROM.put(0,unitsSold); EEPROM.commit();
-        paymentHash=createInvoice();
+        if (strcmp(hash,currentInvoice.hash)==0) {
+          invoiceShown=false; //loop() picks up the next one from the pool
+        } else {
+          createInvoiceQR(); //an older outstanding invoice was paid, put the current one back up
+          latencyQRShown(esp_timer_get_time());
+        }
       } else {
         Serial.println("invalid payment hash from webhook, ignoring");
+        webhook400Total++;
         client.println("HTTP/1.1 400");
         client.println("Content-type:text/html");
         client.println("Connection: close");
@@ -185,6 +270,7 @@ void handleWebhook() {
     } else {
         //never got proper payment header
         Serial.println("invalid payment hash from webhook, ignoring");
+        webhook400Total++;
         client.println("HTTP/1.1 400");
         client.println("Content-type:text/html");
         client.println("Connection: close");
@@ -194,175 +280,430 @@ void handleWebhook() {
   }
 }
 
-String createInvoice() {
-  HTTPClient rest;
-
-  //create post body object
-  JSONVar postData;
-  postData["out"]=false;
-  postData["amount"]=candyCost;
-  timeClient.update(); String memo="For Candy at "; memo.concat(timeClient.getEpochTime());
-  postData["memo"]=memo;
-  postData["webhook"]=webhookEndpoint;
-
-  //make invoice creation API call to LNbits
-  int httpResponseCode=-1;
-  int retries=0;
-  while (httpResponseCode!=201 && retries<maxInvRetries) {
-    retries++;
-    rest.begin(invoiceEndpoint);
-    rest.addHeader("Content-Type", "application/json");
-    rest.addHeader("Host", LNhost);
-    rest.addHeader("X-Api-Key", lnBitsAPIKey);
-    httpResponseCode=rest.POST(JSON.stringify(postData));
+//the invoice request is the same every time except Content-Length and the memo timestamp, so the
+//request line/headers and the body up to the timestamp are formatted once by buildInvoiceRequest()
+char invoiceRequest[768], invoiceBody[320];
+uint16_t invoiceHeadLen, invoiceBodyPrefix;
+HttpParser lnbitsReply; //invoice task only
+
+//false if the endpoint, host, API key or webhook settings don't fit the buffers, the task isn't
+//started then rather than sending LNbits a truncated request
+bool buildInvoiceRequest() {
+  const char *path=strstr(invoiceEndpoint,"://");
+  path=(path!=NULL) ? strchr(path+3,'/') : NULL;
+  int head=snprintf(invoiceRequest,sizeof(invoiceRequest),"POST %s HTTP/1.1\r\nHost: %s\r\nContent-Type: application/json\r\nX-Api-Key: %s\r\nContent-Length: ",(path!=NULL) ? path : "/",LNhost,lnBitsAPIKey);
+  int body=snprintf(invoiceBody,sizeof(invoiceBody),"{\"out\":false,\"amount\":%u,\"webhook\":\"%s\",\"memo\":\"For Candy at ",candyCost,webhookEndpoint);
+  if (head<0 || head>=(int)sizeof(invoiceRequest) || body<0 || body>=(int)sizeof(invoiceBody)) return false;
+  invoiceHeadLen=head;
+  invoiceBodyPrefix=body;
+  return true;
+}
+
+//one request/response on the keep-alive connection, returns the http status or a negative error
+int lnbitsPost(uint16_t len) {
+  if (!lnbitsTLS.connected()) {
+    lnbitsConnectsTotal++;
+    if (!lnbitsTLS.connect(LNhost,443)) return lnbitsConnectFailed;
+  }
+  //reset before writing, so a write to a dead connection reads as "nothing received" to the retry
+  httpReset(lnbitsReply,"HTTP/1.");
+  if (lnbitsTLS.write((const uint8_t*)invoiceRequest,len)!=len) return lnbitsReadFailed;
+
+  uint32_t start=millis();
+  uint8_t chunk[128];
+  while (lnbitsReply.state<HTTP_DONE && (millis()-start)<lnbitsTimeout) {
+    int avail=lnbitsTLS.available();
+    if (avail>0) {
+      int n=lnbitsTLS.read(chunk,(avail<(int)sizeof(chunk)) ? avail : sizeof(chunk));
+      if (n>0) httpFeed(lnbitsReply,chunk,n);
+    } else if (!lnbitsTLS.connected()) {
+      break;
+    } else {
+      delay(1);
+    }
+  }
+  if (lnbitsReply.state!=HTTP_DONE) return lnbitsReadFailed;
+  return lnbitsReply.status;
+}
+
+int requestInvoice(Invoice &inv) {
+  //body first, then its length into the headers, then the body after them
+  int n=snprintf(invoiceBody+invoiceBodyPrefix,sizeof(invoiceBody)-invoiceBodyPrefix,"%u\"}",(uint32_t)timeClient.getEpochTime());
+  if (n<0 || n>=(int)(sizeof(invoiceBody)-invoiceBodyPrefix)) return lnbitsReadFailed;
+  uint16_t bodyLen=invoiceBodyPrefix+n;
+  n=snprintf(invoiceRequest+invoiceHeadLen,sizeof(invoiceRequest)-invoiceHeadLen,"%u\r\n\r\n",bodyLen);
+  if (n<0 || n>=(int)(sizeof(invoiceRequest)-invoiceHeadLen)) return lnbitsReadFailed;
+  uint16_t len=invoiceHeadLen+n;
+  if (len+bodyLen>sizeof(invoiceRequest)) return lnbitsReadFailed;
+  memcpy(invoiceRequest+len,invoiceBody,bodyLen);
+  len+=bodyLen;
+
+  //make invoice creation API call to LNbits over the kept-alive connection, so only the first request
+  //(or one after an error) pays for the TLS handshake. LNbits drops idle connections after a few
+  //seconds, so if a reused connection turns out to be dead, reconnect and send once more
+  uint32_t t=micros();
+  bool reused=lnbitsTLS.connected();
+  int httpResponseCode=lnbitsPost(len);
+  if (httpResponseCode<0 && reused && lnbitsReply.state==HTTP_FIRST_LINE && lnbitsReply.len==0) {
+    lnbitsTLS.stop();
+    httpResponseCode=lnbitsPost(len);
+  }
+  metricRecord(invoiceHttpHist,micros()-t);
+
+  if (httpResponseCode==201) {
+    if (!jsonString(lnbitsReply,"payment_hash",inv.hash,sizeof(inv.hash)) || !jsonString(lnbitsReply,"payment_request",inv.request,sizeof(inv.request))) {
+      Serial.println("unexpected invoice from lnbits, discarding");
+      httpResponseCode=0;
+    } else {
+      //BOLT11 spec supports payment request in all caps - this allows us to stay in the QR code
+      //alphanumeric (0-9, A-Z) space as opposed to binary (mixed case), allowing for support of
+      //longer payment requests in same-sized QR codes
+      for (char *c=inv.request; *c; c++) *c=toupper(*c);
+      inv.expiry=timeClient.getEpochTime() + invoiceExpOffset;
+      if (encodeInvoiceQR(inv)) {
+        Serial.print("invoice created, expires at "); Serial.print(inv.expiry); Serial.print(": "); Serial.println(inv.hash);
+      } else {
+        Serial.print("payment request too long for QR code: "); Serial.println(strlen(inv.request));
+        httpResponseCode=0;
+      }
+    }
+  }
+  if (httpResponseCode!=201 || lnbitsReply.close) lnbitsTLS.stop(); //don't reuse a connection in an unknown state
+  return httpResponseCode;
+}
+
+//invoice task: IDLE while the pool is full, REQUESTING while a call to LNbits is in flight, BACKOFF
+//after a failure. backoff doubles from invoiceBackoffMin up to invoiceRetryWait seconds with jitter,
+//so a fleet of machines doesn't hammer LNbits in lockstep when it comes back up. loop() only reads
+//the state to render it, so webhooks and OTA keep being served the whole time
+void fillInvoicePool( void * ) {
+  static Invoice inv;
+  lnbitsTLS.setInsecure(); //LNbits' certificate isn't checked, same as the HTTPClient default before
+  while (true) {
+    if (poolFree()==0) {
+      invoiceState=INV_IDLE;
+      delay(250);
+      continue;
+    }
+    invoiceState=INV_REQUESTING;
+    int httpResponseCode=requestInvoice(inv);
     if (httpResponseCode==201) {
-      JSONVar respObject=JSON.parse(rest.getString());
-      paymentHash=respObject["payment_hash"];
-      paymentRequest=respObject["payment_request"];
-      timeClient.update();
-      invoiceExpiry=timeClient.getEpochTime() + invoiceExpOffset;
-      Serial.print("invoice created, expires at "); Serial.print(invoiceExpiry); Serial.println(":"); Serial.println(respObject);
-      rest.end();
-      createInvoiceQR();
-      return paymentHash;
+      poolAdd(inv);
+      invoiceFailures=0;
     } else {
       Serial.print("unable to generate invoice from lnbits, http status: ");
       Serial.println(httpResponseCode);
-      display.firstPage();
-      display.fillScreen(GxEPD_WHITE);
-      displayText("INV. CREATE ERR",0,32,false);
-      tempString=""; tempString=LNhost; tempString+=": "; tempString+=httpResponseCode; displayText(tempString,0,8,false);
-      tempString=""; tempString=retries; tempString+="/"; tempString+=maxInvRetries; displayText(tempString,0,-16,true);
-      rest.end();
+      invoiceStatus=httpResponseCode;
+      invoiceRetriesTotal++;
+      uint16_t failures=invoiceFailures+1;
+      uint32_t backoff=(uint32_t)invoiceRetryWait*1000;
+      if (failures<16 && ((uint32_t)invoiceBackoffMin<<(failures-1))<backoff) backoff=(uint32_t)invoiceBackoffMin<<(failures-1);
+      backoff=backoff/2+esp_random()%(backoff/2+1); //equal jitter, somewhere in [backoff/2, backoff]
+      Serial.printf("retrying invoice in %u ms\n",backoff);
+      invoiceBackoffFor=backoff;
+      invoiceBackoffStart=millis();
+      invoiceState=INV_BACKOFF;
+      invoiceFailures=failures;
+      delay(backoff);
     }
   }
-  Serial.println("couldn't create invoice, waiting 60 seconds");
-  tempString="Waiting "; tempString+=invoiceRetryWait; tempString+="s"; displayText(tempString,0,-112,true);
-  uint32_t until=(millis()+(invoiceRetryWait*1000));
-  while (millis()<until) {
-    uint16_t now=millis();
-    uint16_t elapsed=now-(until-(invoiceRetryWait*1000));
-    float prog=float(elapsed)/float(invoiceRetryWait*1000);
-    updateProgress(int(prog*100));
+  Serial.print("killing task");
+  vTaskDelete(NULL);
+}
+
+void showNextInvoice() {
+  if (poolNext(currentInvoice)) {
+    if (invoiceErrorShown) {
+      partialRefreshes=fullRefreshEvery; //full refresh to clear the error screen's ghosting
+      invoiceErrorShown=false;
+    }
+    invoiceShown=true;
+    shownFailures=invoiceFailures;
+    createInvoiceQR();
+    latencyQRShown(esp_timer_get_time());
+    display.hibernate();
+  } else if (invoiceFailures!=shownFailures) {
+    //pool is empty and LNbits is failing, let the customer know why there's no QR code
+    shownFailures=invoiceFailures;
+    showInvoiceError();
+  } else if (invoiceErrorShown && invoiceState==INV_BACKOFF && (millis()-progressDrawnAt)>=progressRedrawEvery) {
+    //redraw the backoff progress bar no faster than the panel can keep up with, and only if it moved
+    uint32_t elapsed=millis()-invoiceBackoffStart, backoff=invoiceBackoffFor;
+    uint8_t percent=(elapsed>=backoff) ? 100 : (elapsed*100)/backoff;
+    if (percent!=progressShown) {
+      updateProgress(percent);
+      progressShown=percent;
+    }
+    progressDrawnAt=millis();
   }
+}
+
+void showInvoiceError() {
   display.setFullWindow();
-  //clear ghosting
-  for (int i=0;i<=2;i++) {
-    display.firstPage();
-    do {
-      display.fillScreen(GxEPD_BLACK);
-    } while (display.nextPage());
-    
-    display.firstPage();
-    do {
-      display.fillScreen(GxEPD_WHITE);
-    } while (display.nextPage());
+  display.fillScreen(GxEPD_WHITE);
+  qrOnScreen=false;
+  drawBanner(BANNER_INV_ERR);
+  char line[32];
+  snprintf(line,sizeof(line),"%s: %d",LNhost,invoiceStatus); displayText(line,0,8,false);
+  snprintf(line,sizeof(line),"Attempt %u",invoiceFailures); displayText(line,0,-16,false);
+  snprintf(line,sizeof(line),"Retry in %us",(invoiceBackoffFor+999)/1000); displayText(line,0,-112,false);
+  //first error screen gets a full refresh, updates to it only need a partial one
+  if (invoiceErrorShown) refreshDisplay(0,0,display.width(),display.height());
+  else fullRefresh();
+  invoiceErrorShown=true;
+  progressShown=0;
+  progressDrawnAt=millis();
+}
+
+//pick the smallest QR version the payment request fits in (biggest modules on the panel), then the
+//highest ECC level that still fits at that version, and encode it into the invoice
+bool encodeInvoiceQR(Invoice &inv) {
+  uint16_t len=strlen(inv.request);
+  for (uint8_t version=1; version<=qrMaxVersion; version++) {
+    if (len>qrAlnumCapacity[version-1][ECC_LOW]) continue;
+    uint8_t ecc=ECC_HIGH;
+    while (len>qrAlnumCapacity[version-1][ecc]) ecc--;
+    QRCode qrcode;
+    if (qrcode_initText(&qrcode, inv.qrModules, version, ecc, inv.request)<0) return false;
+    inv.qrVersion=version; inv.qrEcc=ecc; inv.qrSize=qrcode.size;
+    if (debug) Serial.printf("QR code v%d, ecc %d, %dx%d for %d chars\n",version,ecc,qrcode.size,qrcode.size,len);
+    return true;
   }
-  return "";
+  return false;
 }
 
 bool createInvoiceQR () {
-  Serial.println("creating QR code from payment_request");
-  display.fillScreen(GxEPD_WHITE);
-  displayText("SCAN TOP PAY",0,92,true);
-  // Create the QR code
+  Serial.println("drawing QR code from payment_request");
+  uint32_t t=micros();
+  //matrix was encoded when the invoice was created (see encodeInvoiceQR())
   QRCode qrcode;
-  uint8_t qrcodeData[qrcode_getBufferSize(11)];
-
-  //need a test here to see if paymentRequest exceeds v11 QR data alphanumeric encoding limit of 468B
-  //if we exceed, display error or ?? maybe code to dynamically adjust QR version and reposition on screen?
-  paymentRequest.toUpperCase(); //BOLT11 spec supports payment request in all caps - this allows us to stay in the
-                                //QR code alphanumeric (0-9, A-Z) space as opposed to binary (mixed case), allowing
-                                //for support of longer payment requests in same-sized (v11) QR codes
-  qrcode_initText(&qrcode, qrcodeData, 11, 0, paymentRequest.c_str()); //QR code v11, 61x61, 468 bytes of info
+  qrcode.version=currentInvoice.qrVersion;
+  qrcode.ecc=currentInvoice.qrEcc;
+  qrcode.size=currentInvoice.qrSize;
+  qrcode.modules=currentInvoice.qrModules;
 
-  byte box_x=8;  //start drawing 8 from left
-  byte box_y=16; //start drawing 16 from top
-  byte box_s=3;  //make each square 3 units, 61*3=183px
-  byte init_x=box_x;
+  //largest whole-pixel module size that fits, centered in the area below the banner
+  byte box_s=qrArea/qrcode.size;
+  uint16_t qrPixels=qrcode.size*box_s, rowBytes=(qrPixels+7)/8;
+  byte box_x=(display.width()-qrPixels)/2;
+  byte box_y=qrAreaY+(qrArea-qrPixels)/2;
 
+  //expand the module matrix straight into a packed 1bpp bitmap at box_s scale - each module row is
+  //built once and copied down for the remaining box_s-1 pixel rows - then blit it in one call
+  static uint8_t qrBitmap[((qrArea+7)/8)*qrArea];
+  memset(qrBitmap,0,rowBytes*qrPixels);
   for (uint8_t y=0; y<qrcode.size; y++) {
+    uint8_t *row=qrBitmap+(y*box_s)*rowBytes;
     for (uint8_t x=0; x<qrcode.size; x++) {
       if (qrcode_getModule(&qrcode,x,y)) {
-        display.fillRect(box_x, box_y, box_s, box_s, GxEPD_BLACK);
+        for (uint16_t bit=x*box_s; bit<(x+1)*box_s; bit++) row[bit>>3]|=(0x80>>(bit&7));
       }
-      box_x=box_x+box_s;
     }
-    box_y=box_y+box_s;
-    box_x=init_x;
+    for (uint8_t i=1; i<box_s; i++) memcpy(row+i*rowBytes,row,rowBytes);
   }
-  display.display(false);
+
+  metricRecord(qrRenderHist,micros()-t);
+
+  if (qrOnScreen) {
+    //banner is already up, only the code area changes
+    display.fillRect(0,qrAreaY,display.width(),qrArea,GxEPD_WHITE);
+    display.drawBitmap(box_x,box_y,qrBitmap,qrPixels,qrPixels,GxEPD_BLACK);
+    refreshDisplay(0,qrAreaY,display.width(),qrArea);
+  } else {
+    display.fillScreen(GxEPD_WHITE);
+    drawBanner(BANNER_SCAN);
+    display.drawBitmap(box_x,box_y,qrBitmap,qrPixels,qrPixels,GxEPD_BLACK);
+    refreshDisplay(0,0,display.width(),display.height());
+  }
+  qrOnScreen=true;
   return true;
 }
 
-void dispenseCandy() {
+//paidAt is esp_timer_get_time() when the sale's webhook arrived, 0 for a test dispense
+void dispenseCandy(int64_t paidAt) {
+  if (!dispenseQueueRun((uint32_t)servoRunFor*1000,paidAt)) Serial.println("dispense queue full, sale not dispensed");
+}
+
+//DispenseHal for the real servo
+void servoStart() {
   if (!servo.attach(32)) Serial.println("servo failed to attach");
-  servoStartedAt=millis();
-  if (debug) Serial.printf("should detach at %d\n",servoStartedAt+servoRunFor);
   servo.write(servoRotation);
 }
 
-void stopServo( void * pvParameters ) {
-  while (true) {
-    if (servoStartedAt!=0 && millis()>=(servoStartedAt+servoRunFor)) {
-      uint16_t now=millis();
-      servo.detach();
-      servoStartedAt=0;
-      if (debug) Serial.printf("detaching servo at %d\n\n",now);
-    }
-    delay(1);
-  }
-  Serial.print("killing task");
-  vTaskDelete(NULL);
+void servoStop() {
+  servo.detach();
+}
+
+void servoArm(uint32_t us) {
+  esp_timer_start_once(servoTimer,us);
 }
 
 void showDorian(bool boot) {
   display.fillScreen(GxEPD_WHITE);
-  //###1.01 REFACTOR THIS
+  qrOnScreen=false;
   if (!boot) {
-    displayText("ENJOY YOUR CANDY",0,-188,true);
+    drawBanner(BANNER_ENJOY);
+  }
+  drawAsset(dorian,0,0,0,GxEPD_BLACK); //dorian is drawn inverted, 0 pixels are ink
+  if (boot) {
+    fullRefresh();
+  } else {
+    refreshDisplay(0,0,display.width(),display.height());
   }
-  display.drawInvertedBitmap(0, 0, dorian, 200, 180, GxEPD_BLACK);
-  display.display(false);
 }
 
 void checkSerialIn() {
   //for testing dispense without actually making a ln payment
   //send "pay" in serial console to trigger
-  char c;
-  String input;
+  static char input[16];
+  static uint8_t inputLen;
   
   while (Serial.available()>0) {
-    c=Serial.read();
+    char c=Serial.read();
+    if (c=='\r') continue;
     if (c!='\n') {
-      input+=c;
-    } else {
-      break;
+      if (inputLen<sizeof(input)-1) input[inputLen++]=c;
+      continue;
+    }
+    input[inputLen]='\0';
+    inputLen=0;
+    if (strcmp(input,"pay")==0) {
+      dispenseCandy(0);
+    } else if (strcmp(input,"stats")==0) {
+      latencyReport();
+    } else if (strcmp(input,"journal")==0) {
+      journalFlush(true);
+      uint32_t at=0;
+      JournalRecord rec;
+      char line[128];
+      while (journalNext(at,rec)) {
+        journalCsv(rec,line,sizeof(line));
+        Serial.print(line);
+      }
     }
-  }
-  
-  if (input=="pay") {
-    dispenseCandy();
-    servo.write(servoRotation);
   }
 }
 
 void updateProgress(int percent) {
-  display.setPartialWindow(0,0,display.width(),display.height());
-  percent*=2;
-  if (percent<=display.width()-12) {
-    display.setCursor(percent-2,188); display.print("|");
-    display.setCursor(percent-1,188); display.print("|");
-    display.setCursor(percent,188); display.print("|");
+  //bar along the bottom of the screen, refresh just that strip
+  display.fillRect(0,178,((display.width()-12)*percent)/100,12,GxEPD_BLACK);
+  refreshDisplay(0,176,display.width(),16); //counts towards the next full refresh like any other partial
+}
+
+//decode an asset's pixel runs (see tools/mkasset.py) straight onto the display, drawing the runs of
+//ink pixels as horizontal lines split at the row ends - nothing is decompressed into RAM
+void drawAsset(const Asset &asset, int16_t ax, int16_t ay, uint8_t ink, uint16_t color) {
+  const uint8_t *p=asset.data, *end=asset.data+asset.size;
+  uint32_t pos=0, total=(uint32_t)asset.width*asset.height;
+  uint8_t bit=0;
+  while (pos<total && p<end) {
+    uint32_t run=0;
+    uint8_t shift=0, b;
+    do {
+      b=pgm_read_byte(p++);
+      run|=(uint32_t)(b&0x7F)<<shift;
+      shift+=7;
+    } while ((b&0x80) && p<end);
+    if (run>total-pos) run=total-pos;
+    if (bit==ink) {
+      for (uint32_t at=pos; at<pos+run; ) {
+        uint16_t col=at%asset.width, n=asset.width-col;
+        if (n>pos+run-at) n=pos+run-at;
+        display.drawFastHLine(ax+col,ay+at/asset.width,n,color);
+        at+=n;
+      }
+    }
+    pos+=run;
+    bit^=1;
+  }
+}
+
+void layoutBanners() {
+  for (uint8_t i=0; i<sizeof(banners)/sizeof(banners[0]); i++) {
+    display.getTextBounds(banners[i].text,0,banners[i].yOffset,&tbx,&tby,&tbw,&tbh);
+    banners[i].x=((display.width()-tbw)/2)-tbx;
+    banners[i].y=((display.height()-tbh)/2)-tby;
   }
-  display.display(true);
 }
 
-void displayText(String temp, uint16_t xOffset, uint16_t yOffset, bool paint) {
+void drawBanner(BannerId id) {
+  display.setCursor(banners[id].x,banners[id].y);
+  display.print(banners[id].text);
+}
+
+void displayText(const char *temp, uint16_t xOffset, uint16_t yOffset, bool paint) {
   display.getTextBounds(temp,xOffset,yOffset,&tbx,&tby,&tbw,&tbh);
   x=((display.width()-tbw)/2)-tbx;
   y=((display.height()-tbh)/2)-tby;
   display.setCursor(x,y);
   display.print(temp);
-  if (paint) display.display(false);
+  if (paint) fullRefresh();
+}
+
+//partial refresh of the given window from the frame buffer, with a full refresh every fullRefreshEvery
+//updates to keep ghosting in check
+void refreshDisplay(int16_t wx, int16_t wy, int16_t ww, int16_t wh) {
+  if (partialRefreshes>=fullRefreshEvery) {
+    fullRefresh();
+  } else {
+    uint32_t t=micros();
+    display.displayWindow(wx,wy,ww,wh);
+    metricRecord(refreshHist,micros()-t);
+    partialRefreshes++;
+  }
+}
+
+void fullRefresh() {
+  uint32_t t=micros();
+  display.display(false);
+  metricRecord(refreshHist,micros()-t);
+  partialRefreshes=0;
+}
+
+//every sale still in the journal as CSV, oldest first, for reconciling against the LNbits wallet.
+//up to 1024 lines, so it goes out chunked a page at a time
+void handleJournal() {
+  static char page[1024];
+  journalFlush(true);
+  ota.setContentLength(CONTENT_LENGTH_UNKNOWN);
+  ota.sendHeader("Connection", "close");
+  ota.send(200,"text/csv","");
+  size_t len=snprintf(page,sizeof(page),"seq,epoch,payment_hash,amount\n");
+  uint32_t at=0;
+  JournalRecord rec;
+  while (journalNext(at,rec)) {
+    if (len>sizeof(page)-128) {
+      ota.sendContent(page,len);
+      len=0;
+    }
+    len+=journalCsv(rec,page+len,sizeof(page)-len);
+  }
+  ota.sendContent(page,len);
+  ota.sendContent(page,0); //last chunk
+}
+
+//GET /metrics, Prometheus text format
+void handleMetrics() {
+  static char page[6144];
+  size_t size=sizeof(page), len=0;
+  page[0]='\0';
+  len=metricsHistogram(page,size,len,invoiceHttpHist);
+  len=metricsHistogram(page,size,len,webhookParseHist);
+  len=metricsHistogram(page,size,len,qrRenderHist);
+  len=metricsHistogram(page,size,len,refreshHist);
+  len=metricsHistogram(page,size,len,servoHist);
+  len=metricsValue(page,size,len,"lncandy_units_sold_total","counter","Sales recorded",unitsSold);
+  len=metricsValue(page,size,len,"lncandy_lnbits_connects_total","counter","New TLS connections to LNbits",lnbitsConnectsTotal);
+  len=metricsValue(page,size,len,"lncandy_invoice_retries_total","counter","Failed LNbits invoice requests",invoiceRetriesTotal);
+  len=metricsValue(page,size,len,"lncandy_webhook_rejected_total","counter","Webhooks answered with a 400",webhook400Total);
+  len=metricsValue(page,size,len,"lncandy_invoice_expired_total","counter","Invoices that expired unpaid",invoiceExpiredTotal);
+  len=metricsValue(page,size,len,"lncandy_heap_free_bytes","gauge","Free heap",ESP.getFreeHeap());
+  len=metricsValue(page,size,len,"lncandy_heap_min_free_bytes","gauge","Lowest free heap since boot",ESP.getMinFreeHeap());
+  len=metricsValue(page,size,len,"lncandy_heap_largest_block_bytes","gauge","Largest free heap block",heap_caps_get_largest_free_block(MALLOC_CAP_8BIT));
+  len=metricsPrintf(page,size,len,"# HELP lncandy_stack_free_bytes Least free stack since the task started\n# TYPE lncandy_stack_free_bytes gauge\n");
+  len=metricsPrintf(page,size,len,"lncandy_stack_free_bytes{task=\"loop\"} %u\n",uxTaskGetStackHighWaterMark(loopTask));
+  len=metricsPrintf(page,size,len,"lncandy_stack_free_bytes{task=\"dispense\"} %u\n",uxTaskGetStackHighWaterMark(dispenseTask));
+  //no invoice task if the request didn't fit its buffers, and NULL would report the loop task's stack
+  if (invoiceTask!=NULL) len=metricsPrintf(page,size,len,"lncandy_stack_free_bytes{task=\"invoice\"} %u\n",uxTaskGetStackHighWaterMark(invoiceTask));
+  ota.send(200,"text/plain; version=0.0.4",page);
 }
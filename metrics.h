@@ -0,0 +1,62 @@
+/*
+ * Runtime Metrics
+ */
+
+//fixed-bucket latency histograms for the hot paths, rendered in Prometheus text format for /metrics on
+//the OTA web server. recording is a short bucket scan and a couple of adds with no locking - each
+//histogram only ever has one writer task, so a scrape racing a record is at worst one event behind
+
+#include <stdarg.h>
+#include <esp_heap_caps.h>
+
+const uint8_t metricBuckets=12;
+const uint32_t metricBounds[metricBuckets]={100,500,1000,5000,10000,50000,100000,250000,500000,1000000,2500000,5000000}; //us
+
+struct Histogram {
+  const char *name, *help;
+  uint32_t counts[metricBuckets+1]; //per bucket, last one is +Inf
+  uint32_t count;
+  uint64_t sum; //us
+};
+
+void metricRecord(Histogram &h, uint32_t us) {
+  uint8_t i=0;
+  while (i<metricBuckets && us>metricBounds[i]) i++;
+  h.counts[i]++;
+  h.count++;
+  h.sum+=us;
+}
+
+//printf onto the end of the page in buf, returns the new length (clamped to the buffer)
+size_t metricsPrintf(char *buf, size_t size, size_t len, const char *fmt, ...) {
+  if (len>=size) return len;
+  va_list args;
+  va_start(args,fmt);
+  int n=vsnprintf(buf+len,size-len,fmt,args);
+  va_end(args);
+  if (n<0) return len;
+  return (len+n<size) ? len+n : size-1;
+}
+
+size_t metricsHistogram(char *buf, size_t size, size_t len, const Histogram &h) {
+  len=metricsPrintf(buf,size,len,"# HELP %s %s\n# TYPE %s histogram\n",h.name,h.help,h.name);
+  uint32_t cumulative=0;
+  for (uint8_t i=0; i<metricBuckets; i++) {
+    cumulative+=h.counts[i];
+    len=metricsPrintf(buf,size,len,"%s_bucket{le=\"%g\"} %u\n",h.name,metricBounds[i]/1e6,cumulative);
+  }
+  len=metricsPrintf(buf,size,len,"%s_bucket{le=\"+Inf\"} %u\n",h.name,h.count);
+  len=metricsPrintf(buf,size,len,"%s_sum %.6f\n%s_count %u\n",h.name,h.sum/1e6,h.name,h.count);
+  return len;
+}
+
+size_t metricsValue(char *buf, size_t size, size_t len, const char *name, const char *type, const char *help, uint32_t value) {
+  return metricsPrintf(buf,size,len,"# HELP %s %s\n# TYPE %s %s\n%s %u\n",name,help,name,type,name,value);
+}
+
+Histogram invoiceHttpHist={"lncandy_invoice_http_seconds","LNbits invoice creation request time",{},0,0};
+Histogram webhookParseHist={"lncandy_webhook_parse_seconds","Webhook request parse time",{},0,0};
+Histogram qrRenderHist={"lncandy_qr_render_seconds","QR code rasterize time",{},0,0};
+Histogram refreshHist={"lncandy_epaper_refresh_seconds","E-paper refresh time",{},0,0};
+Histogram servoHist={"lncandy_servo_run_seconds","Actual servo run time per dispense",{},0,0};
+volatile uint32_t invoiceRetriesTotal, webhook400Total, invoiceExpiredTotal, lnbitsConnectsTotal;
@@ -1,40 +1,40 @@
 /*
  * Server Index Page
  */
- 
-const char* serverIndex = 
-"<script src='https://ajax.googleapis.com/ajax/libs/jquery/3.2.1/jquery.min.js'></script>"
-"<form method='POST' action='#' enctype='multipart/form-data' id='upload_form'>"
-   "<input type='file' name='update'>"
-        "<input type='submit' value='Update'>"
-    "</form>"
- "<div id='prg'>progress: 0%</div>"
- "<script>"
-  "$('form').submit(function(e){"
-  "e.preventDefault();"
-  "var form = $('#upload_form')[0];"
-  "var data = new FormData(form);"
-  " $.ajax({"
-  "url: '/update',"
-  "type: 'POST',"
-  "data: data,"
-  "contentType: false,"
-  "processData:false,"
-  "xhr: function() {"
-  "var xhr = new window.XMLHttpRequest();"
-  "xhr.upload.addEventListener('progress', function(evt) {"
-  "if (evt.lengthComputable) {"
-  "var per = evt.loaded / evt.total;"
-  "$('#prg').html('progress: ' + Math.round(per*100) + '%');"
-  "}"
-  "}, false);"
-  "return xhr;"
-  "},"
-  "success:function(d, s) {"
-  "console.log('success!')" 
- "},"
- "error: function (a, b, c) {"
- "}"
- "});"
- "});"
- "</script>";
+
+//self-contained (no CDN, the machine's network may not reach one). takes a .bin or .bin.gz and the
+//sha256 of the uncompressed .bin (sha256sum firmware.bin), shows upload progress and speed, then the
+//device's reply with the flash throughput
+const char* serverIndex =
+"<form id='f'>"
+  "<input type='file' id='bin' accept='.bin,.gz'><br>"
+  "<input type='text' id='sha' size='66' placeholder='sha256 of the uncompressed .bin (optional)'><br>"
+  "<input type='submit' value='Update'>"
+"</form>"
+"<div id='prg'>progress: 0%</div>"
+"<pre id='res'></pre>"
+"<script>"
+  "document.getElementById('f').onsubmit=function(e){"
+    "e.preventDefault();"
+    "var file=document.getElementById('bin').files[0];"
+    "if(!file)return;"
+    "var data=new FormData();"
+    "data.append('update',file);"
+    "var sha=document.getElementById('sha').value.trim();"
+    "var xhr=new XMLHttpRequest();"
+    "var prg=document.getElementById('prg'),res=document.getElementById('res');"
+    "var start=Date.now();"
+    "xhr.upload.onprogress=function(evt){"
+      "if(!evt.lengthComputable)return;"
+      "var s=(Date.now()-start)/1000;"
+      "prg.textContent='progress: '+Math.round(evt.loaded/evt.total*100)+'%, '+(s>0?(evt.loaded/1048576/s).toFixed(2):'0')+' MB/s';"
+    "};"
+    "xhr.onload=function(){"
+      "prg.textContent+=' - done in '+((Date.now()-start)/1000).toFixed(1)+' s';"
+      "res.textContent=xhr.responseText;"
+    "};"
+    "xhr.onerror=function(){res.textContent='upload failed';};"
+    "xhr.open('POST','/update'+(sha?'?sha256='+encodeURIComponent(sha):''));"
+    "xhr.send(data);"
+  "};"
+"</script>";
@@ -0,0 +1,284 @@
+/*
+ * Streaming OTA
+ */
+
+//firmware uploads arrive through the WebServer upload callback in chunks. gzip'd images are inflated
+//as they come in (ROM miniz, raw deflate after the gzip header), a plain .bin passes straight
+//through. the output is gathered into one of two sector-sized buffers and each full buffer is handed
+//to the writer task, which hashes it and writes it to flash while the next one fills up. the SHA-256
+//of the whole (uncompressed) image is checked against the one the page sent before Update.end()
+
+#if __has_include("esp32/rom/miniz.h")
+#include "esp32/rom/miniz.h"
+#else
+#include "rom/miniz.h"
+#endif
+#include <mbedtls/sha256.h>
+
+const uint16_t otaBufSize=4096;
+const uint8_t otaFlush=0xFF; //chunk index that asks the writer to signal once everything before it is written
+
+enum OtaFormat { OTA_DETECT, OTA_RAW, OTA_GZIP_HEADER, OTA_DEFLATE, OTA_GZIP_TRAILER };
+
+struct OtaChunk {
+  uint8_t buf;
+  uint16_t len;
+};
+
+QueueHandle_t otaFull, otaFree;
+SemaphoreHandle_t otaFlushed;
+uint8_t *otaBuf[2];
+uint8_t otaCur;
+uint16_t otaFill;
+volatile bool otaFailed;
+char otaError[48];
+
+OtaFormat otaFormat;
+uint8_t gzField, gzFlags, gzTail[8]; //gzTail: last 8 bytes uploaded, the trailer once it's all in
+uint16_t gzPos, gzSkip, gzXlen;
+tinfl_decompressor *otaInflate;
+uint8_t *otaDict; //inflate output window, TINFL_LZ_DICT_SIZE
+size_t otaDictPos;
+
+mbedtls_sha256_context otaSha;
+uint8_t otaExpected[32];
+bool otaCheckSha;
+uint32_t otaIn, otaOut, otaStartedAt;
+volatile uint32_t otaFlashUs; //writer task time in sha256 + Update.write()
+
+void otaFail(const char *why) {
+  if (!otaFailed) strncpy(otaError,why,sizeof(otaError)-1);
+  otaFailed=true;
+}
+
+void otaWriter( void * ) {
+  OtaChunk chunk;
+  while (true) {
+    xQueueReceive(otaFull,&chunk,portMAX_DELAY);
+    if (chunk.buf==otaFlush) {
+      xSemaphoreGive(otaFlushed);
+      continue;
+    }
+    if (!otaFailed) {
+      uint32_t t=micros();
+      mbedtls_sha256_update(&otaSha,otaBuf[chunk.buf],chunk.len);
+      if (Update.write(otaBuf[chunk.buf],chunk.len)!=chunk.len) otaFail(Update.errorString());
+      otaFlashUs+=micros()-t;
+    }
+    xQueueSend(otaFree,&chunk.buf,portMAX_DELAY);
+  }
+  Serial.print("killing task");
+  vTaskDelete(NULL);
+}
+
+void otaInit() {
+  otaFull=xQueueCreate(3,sizeof(OtaChunk));
+  otaFree=xQueueCreate(2,sizeof(uint8_t));
+  otaFlushed=xSemaphoreCreateBinary();
+  xTaskCreatePinnedToCore(otaWriter,"otaWriter",4096,NULL,1,NULL,0);
+}
+
+//hand the current buffer to the writer and wait for a free one, which only blocks if the writer is
+//a whole buffer behind
+void otaSubmit() {
+  OtaChunk chunk={otaCur,otaFill};
+  xQueueSend(otaFull,&chunk,portMAX_DELAY);
+  xQueueReceive(otaFree,&otaCur,portMAX_DELAY);
+  otaFill=0;
+}
+
+//wait until the writer has written everything submitted so far
+void otaDrain() {
+  if (otaFill>0) otaSubmit();
+  OtaChunk flush={otaFlush,0};
+  xQueueSend(otaFull,&flush,portMAX_DELAY);
+  xSemaphoreTake(otaFlushed,portMAX_DELAY);
+}
+
+void otaEmit(const uint8_t *data, size_t n) {
+  otaOut+=n;
+  while (n>0 && !otaFailed) {
+    size_t room=otaBufSize-otaFill;
+    if (room>n) room=n;
+    memcpy(otaBuf[otaCur]+otaFill,data,room);
+    otaFill+=room; data+=room; n-=room;
+    if (otaFill==otaBufSize) otaSubmit();
+  }
+}
+
+//gzip header fields after the 10 fixed bytes: 1 xlen, 2 extra, 3 name, 4 comment, 5 header crc
+void gzipNextField() {
+  while (true) {
+    gzField++;
+    if (gzField==1 && (gzFlags&4)) { gzSkip=2; gzXlen=0; return; }
+    if (gzField==2 && (gzFlags&4) && gzXlen>0) { gzSkip=gzXlen; return; }
+    if ((gzField==3 && (gzFlags&8)) || (gzField==4 && (gzFlags&16))) return;
+    if (gzField==5 && (gzFlags&2)) { gzSkip=2; return; }
+    if (gzField>=6) {
+      otaFormat=OTA_DEFLATE;
+      return;
+    }
+  }
+}
+
+//consume gzip header bytes, returns how many were used
+size_t gzipHeader(const uint8_t *data, size_t n) {
+  size_t i=0;
+  while (i<n && otaFormat==OTA_GZIP_HEADER) {
+    uint8_t c=data[i++];
+    switch (gzField) {
+      case 0:
+        if (gzPos==2 && c!=8) otaFail("gzip isn't deflate");
+        if (gzPos==3) gzFlags=c;
+        if (++gzPos==10) gzipNextField();
+        break;
+      case 1:
+        gzXlen|=c<<(8*(2-gzSkip));
+        if (--gzSkip==0) gzipNextField();
+        break;
+      case 2: case 5:
+        if (--gzSkip==0) gzipNextField();
+        break;
+      default:
+        if (c==0) gzipNextField(); //end of name/comment
+    }
+  }
+  return i;
+}
+
+//inflate input into the output window and pass whatever comes out on, returns bytes of input used
+size_t otaInflateChunk(const uint8_t *data, size_t n) {
+  size_t used=0;
+  while (!otaFailed) {
+    size_t inBytes=n-used, outBytes=TINFL_LZ_DICT_SIZE-otaDictPos;
+    tinfl_status status=tinfl_decompress(otaInflate,data+used,&inBytes,otaDict,otaDict+otaDictPos,&outBytes,TINFL_FLAG_HAS_MORE_INPUT);
+    used+=inBytes;
+    if (outBytes>0) {
+      otaEmit(otaDict+otaDictPos,outBytes);
+      otaDictPos=(otaDictPos+outBytes)&(TINFL_LZ_DICT_SIZE-1);
+    }
+    if (status==TINFL_STATUS_DONE) {
+      otaFormat=OTA_GZIP_TRAILER;
+      break;
+    }
+    if (status<0) otaFail("corrupt gzip data");
+    if (status==TINFL_STATUS_NEEDS_MORE_INPUT) break;
+  }
+  return used;
+}
+
+bool otaBegin(const char *sha256) {
+  otaFailed=false;
+  otaError[0]='\0';
+  otaFormat=OTA_DETECT;
+  gzField=0; gzPos=0; gzFlags=0;
+  otaIn=0; otaOut=0; otaFill=0; otaDictPos=0;
+  memset(gzTail,0,sizeof(gzTail));
+  otaStartedAt=millis();
+  otaFlashUs=0;
+  otaCheckSha=(strlen(sha256)>0);
+  if (otaCheckSha) hashFromHex(sha256,otaExpected);
+  mbedtls_sha256_init(&otaSha);
+  mbedtls_sha256_starts(&otaSha,0);
+
+  xQueueReset(otaFree);
+  for (uint8_t i=0; i<2; i++) {
+    if (otaBuf[i]==NULL) otaBuf[i]=(uint8_t*)malloc(otaBufSize);
+    if (otaBuf[i]==NULL) otaFail("out of memory");
+  }
+  uint8_t spare=1;
+  xQueueSend(otaFree,&spare,0);
+  otaCur=0;
+  if (!otaFailed && !Update.begin(UPDATE_SIZE_UNKNOWN)) otaFail(Update.errorString()); //start with max available size
+  return !otaFailed;
+}
+
+void otaWrite(const uint8_t *data, size_t n) {
+  otaIn+=n;
+  //keep the last 8 bytes of everything uploaded: the ROM inflate can report bytes after the end of
+  //the deflate stream as used, so the trailer can't be collected from what's left over after it
+  if (n>=sizeof(gzTail)) {
+    memcpy(gzTail,data+n-sizeof(gzTail),sizeof(gzTail));
+  } else {
+    memmove(gzTail,gzTail+n,sizeof(gzTail)-n);
+    memcpy(gzTail+sizeof(gzTail)-n,data,n);
+  }
+  size_t i=0;
+  while (i<n && !otaFailed) {
+    switch (otaFormat) {
+      case OTA_DETECT:
+        //gzip magic is 1f 8b, an esp32 app image starts with e9
+        if (data[i]==0x1f) {
+          otaFormat=OTA_GZIP_HEADER;
+          otaInflate=(tinfl_decompressor*)malloc(sizeof(tinfl_decompressor));
+          otaDict=(uint8_t*)malloc(TINFL_LZ_DICT_SIZE);
+          if (otaInflate==NULL || otaDict==NULL) otaFail("out of memory");
+          else tinfl_init(otaInflate);
+        } else {
+          otaFormat=OTA_RAW;
+        }
+        break;
+      case OTA_RAW:
+        otaEmit(data+i,n-i);
+        i=n;
+        break;
+      case OTA_GZIP_HEADER:
+        i+=gzipHeader(data+i,n-i);
+        break;
+      case OTA_DEFLATE:
+        i+=otaInflateChunk(data+i,n-i);
+        break;
+      case OTA_GZIP_TRAILER:
+        //crc32 and size of the uncompressed data, the size is checked from gzTail in otaEnd()
+        i=n;
+        break;
+    }
+  }
+}
+
+void otaRelease() {
+  free(otaInflate); otaInflate=NULL;
+  free(otaDict); otaDict=NULL;
+  for (uint8_t i=0; i<2; i++) {
+    free(otaBuf[i]);
+    otaBuf[i]=NULL;
+  }
+}
+
+//finish the update, result (OK/FAIL and throughput) goes into buf
+bool otaEnd(char *buf, size_t size) {
+  otaDrain();
+  uint8_t sha[32];
+  mbedtls_sha256_finish(&otaSha,sha);
+  mbedtls_sha256_free(&otaSha);
+  if (otaFormat==OTA_GZIP_HEADER || otaFormat==OTA_DEFLATE) otaFail("gzip data ends early");
+  if (otaFormat==OTA_GZIP_TRAILER) {
+    uint32_t isize=gzTail[4]|(gzTail[5]<<8)|(gzTail[6]<<16)|((uint32_t)gzTail[7]<<24);
+    if (isize!=otaOut) otaFail("gzip size mismatch");
+  }
+  if (otaCheckSha && memcmp(sha,otaExpected,32)!=0) otaFail("sha256 mismatch");
+  if (!otaFailed && !Update.end(true)) otaFail(Update.errorString()); //true to set the size to the current progress
+  if (otaFailed) Update.abort();
+  otaRelease();
+
+  //end to end is from the first byte of the upload, so it includes the network. flash is just the
+  //writer task's time in sha256 + Update.write(), what the flash side could sustain on its own
+  uint32_t ms=millis()-otaStartedAt, flashUs=otaFlashUs;
+  char hex[65];
+  for (uint8_t i=0; i<32; i++) sprintf(hex+i*2,"%02x",sha[i]);
+  if (otaFailed) {
+    snprintf(buf,size,"FAIL: %s",otaError);
+  } else {
+    snprintf(buf,size,"OK: %u bytes (%u uploaded) in %u ms\n%.2f MB/s end to end incl. network, %.2f MB/s flash (sha256+write)\nsha256 %s",otaOut,otaIn,ms,
+      ms ? otaOut/1048.576/ms : 0.0,flashUs ? otaOut/1.048576/flashUs : 0.0,hex);
+  }
+  return !otaFailed;
+}
+
+void otaAbort() {
+  otaFail("upload aborted");
+  otaDrain();
+  mbedtls_sha256_free(&otaSha);
+  Update.abort();
+  otaRelease();
+}
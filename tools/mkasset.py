@@ -0,0 +1,96 @@
+#!/usr/bin/env python3
+"""
+Compress monochrome bitmaps for the sketch.
+
+Reads 1bpp bitmaps stored as C byte arrays (the image2cpp / Adafruit GFX
+format: rows packed MSB first, each row padded to a whole byte) and
+run-length encodes the pixels, row after row with the padding dropped. Runs
+alternate between 0 and 1 pixels, starting with 0. Each run length is a
+LEB128 varint: 7 bits per byte, high bit set on every byte but the last.
+drawAsset() in the sketch decodes them straight onto the display.
+
+  tools/mkasset.py assets/dorian.h:dorian:200:180 > assets.h
+
+Each argument is source:name:width:height. Raw and compressed sizes are
+reported on stderr.
+"""
+import re
+import sys
+
+
+def read_bitmap(path):
+    src = open(path).read()
+    src = re.sub(r'/\*.*?\*/', '', src, flags=re.S)
+    src = re.sub(r'//[^\n]*', '', src)
+    body = src[src.index('{') + 1:src.rindex('}')]
+    return bytes(int(v, 16) for v in re.findall(r'0x([0-9a-fA-F]{1,2})', body))
+
+
+def pixels(raw, width, height):
+    stride = (width + 7) // 8
+    for y in range(height):
+        for x in range(width):
+            yield (raw[y * stride + x // 8] >> (7 - x % 8)) & 1
+
+
+def encode(raw, width, height):
+    runs = []
+    bit, run = 0, 0
+    for p in pixels(raw, width, height):
+        if p != bit:
+            runs.append(run)
+            bit, run = p, 0
+        run += 1
+    runs.append(run)
+    out = bytearray()
+    for run in runs:
+        while run >= 0x80:
+            out.append(0x80 | (run & 0x7F))
+            run >>= 7
+        out.append(run)
+    return bytes(out)
+
+
+def decode(data, width, height):
+    out = []
+    bit, i = 0, 0
+    while i < len(data):
+        run, shift = 0, 0
+        while True:
+            b = data[i]
+            i += 1
+            run |= (b & 0x7F) << shift
+            shift += 7
+            if not b & 0x80:
+                break
+        out += [bit] * run
+        bit ^= 1
+    return out
+
+
+def main(args):
+    if not args:
+        sys.exit(__doc__)
+    print('/*\n * Compressed Assets - generated by tools/mkasset.py, do not edit\n */\n')
+    print('struct Asset {\n  const uint8_t *data; //pixel runs, see tools/mkasset.py\n  uint16_t size, width, height;\n};\n')
+    for arg in args:
+        path, name, width, height = arg.split(':')
+        width, height = int(width), int(height)
+        raw = read_bitmap(path)
+        expected = (width + 7) // 8 * height
+        if len(raw) != expected:
+            sys.exit('%s: %d bytes, expected %d for %dx%d' % (path, len(raw), expected, width, height))
+        packed = encode(raw, width, height)
+        assert decode(packed, width, height) == list(pixels(raw, width, height))
+        sys.stderr.write('%s: %d bytes raw, %d compressed (%.0f%%)\n' % (name, len(raw), len(packed), 100.0 * len(packed) / len(raw)))
+
+        print('const uint8_t %sData[] PROGMEM = {' % name)
+        print('  // %s, %dx%dpx, %d bytes raw' % (path, width, height, len(raw)))
+        for i in range(0, len(packed), 16):
+            print('  ' + ', '.join('0x%02x' % b for b in packed[i:i + 16]) + ',')
+        print('};')
+        print('const Asset %s={%sData, %d, %d, %d};\n' % (name, name, len(packed), width, height))
+
+
+if __name__ == '__main__':
+    main(sys.argv[1:])